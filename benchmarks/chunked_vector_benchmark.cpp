@@ -0,0 +1,64 @@
+// Worst case push_back latency of hpp::chunked_vector against std::vector.
+//
+//     hpp_chunked_vector_benchmark [elements]
+//
+// Defaults to 10M elements of 64 bytes. Times every push_back on its own and
+// prints the total, the 99.99th percentile and the slowest call. std::vector
+// moves all elements when it grows, so its slowest push_back grows with the
+// size. chunked_vector only ever allocates one more chunk.
+// Build in release with -DBUILD_HPP_BENCHMARKS=ON.
+
+#include <hpp/chunked_vector.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+
+struct element
+{
+    std::array<uint64_t, 8> values{};
+};
+
+template<typename Container>
+void run(const char* name, size_t count)
+{
+    std::vector<double> latencies(count);
+    Container container;
+
+    const auto start = clock_type::now();
+    for(size_t i = 0; i < count; ++i)
+    {
+        element value;
+        value.values[0] = i;
+
+        const auto begin = clock_type::now();
+        container.push_back(value);
+        const auto end = clock_type::now();
+        latencies[i] = std::chrono::duration<double, std::nano>(end - begin).count();
+    }
+    const auto total = std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+
+    const auto p9999 = latencies.begin() + std::ptrdiff_t(double(count - 1) * 0.9999);
+    std::nth_element(latencies.begin(), p9999, latencies.end());
+    const auto worst = *std::max_element(latencies.begin(), latencies.end());
+    std::printf("%-14s %9zu elements: total %8.1f ms, p99.99 %9.0f ns, max %11.0f ns%s\n", name, count, total,
+                *p9999, worst, container.back().values[0] == count - 1 ? "" : " (wrong value)");
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const size_t count = argc > 1 ? size_t(std::strtoull(argv[1], nullptr, 10)) : 10000000;
+
+    run<std::vector<element>>("std::vector", count);
+    run<hpp::chunked_vector<element>>("chunked_vector", count);
+    return 0;
+}
@@ -0,0 +1,96 @@
+// hpp::concurrent_slot_map throughput at 1 to 64 threads.
+//
+//     hpp_concurrent_slot_map_benchmark [operations per thread]
+//
+// Defaults to 1M operations per thread. The map is filled with 1M values
+// first. Every thread then runs a mix of 90% find() of random shared keys
+// and 10% insert() plus erase() of its own values, so the writers reuse each
+// other's slots. Prints the total operations per second for 1, 2, 4, ... 64
+// threads.
+// Build in release with -DBUILD_HPP_BENCHMARKS=ON.
+
+#include <hpp/concurrent_slot_map.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+using map_type = hpp::concurrent_slot_map<uint64_t>;
+using key_type = map_type::key_type;
+
+constexpr size_t shared_count = 1000000;
+
+uint64_t run_thread(map_type& map, const std::vector<key_type>& shared, size_t operations, uint64_t seed)
+{
+    uint64_t state = seed * 0x9e3779b97f4a7c15ull + 1;
+    uint64_t found{};
+    std::vector<key_type> own;
+    own.reserve(64);
+    for(size_t i = 0; i < operations; ++i)
+    {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        const auto random = state >> 33;
+        if(random % 10 != 0)
+        {
+            found += map.contains(shared[random % shared.size()]) ? 1 : 0;
+        }
+        else if(own.size() < 64)
+        {
+            own.push_back(map.insert(i));
+        }
+        else
+        {
+            for(const auto& key : own)
+            {
+                map.erase(key);
+            }
+            own.clear();
+        }
+    }
+    for(const auto& key : own)
+    {
+        map.erase(key);
+    }
+    return found;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const size_t operations = argc > 1 ? size_t(std::strtoull(argv[1], nullptr, 10)) : 1000000;
+
+    map_type map(size_t(1) << 22);
+    std::vector<key_type> shared;
+    shared.reserve(shared_count);
+    for(size_t i = 0; i < shared_count; ++i)
+    {
+        shared.push_back(map.insert(i));
+    }
+
+    for(size_t thread_count = 1; thread_count <= 64; thread_count *= 2)
+    {
+        std::atomic<uint64_t> found{0};
+        std::vector<std::thread> threads;
+        const auto start = clock_type::now();
+        for(size_t t = 0; t < thread_count; ++t)
+        {
+            threads.emplace_back([&, t]() { found += run_thread(map, shared, operations, t); });
+        }
+        for(auto& thread : threads)
+        {
+            thread.join();
+        }
+        const auto seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+        std::printf("%2zu threads: %8.2f Mops/s, %zu values left%s\n", thread_count,
+                    double(operations * thread_count) / seconds / 1e6, map.size(),
+                    map.size() == shared_count ? "" : " (leaked values)");
+    }
+    return 0;
+}
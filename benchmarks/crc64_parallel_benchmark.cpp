@@ -0,0 +1,55 @@
+// crc64 throughput: bytewise hash_impl, crc64_fast and crc64_parallel.
+//
+//     hpp_crc64_parallel_benchmark [max bytes] [threads]
+//
+// Defaults to 8GB and std::thread::hardware_concurrency() threads. Hashes
+// buffers of 1MB, 2MB, 4MB, ... up to the maximum (the buffer is allocated
+// once at the largest size, so it needs that much memory) and prints GB/s.
+// Build in release with -DBUILD_HPP_BENCHMARKS=ON.
+
+#include <hpp/crc_parallel.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+
+template<typename Hash>
+void run(const char* name, size_t size, uint64_t expected, Hash&& hash)
+{
+    const auto start = clock_type::now();
+    const auto crc = hash();
+    const auto seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+    std::printf("%-14s %6zu MB: %7.2f GB/s%s\n", name, size >> 20, double(size) / seconds / 1e9,
+                crc == expected ? "" : " (wrong crc)");
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const size_t max_size = argc > 1 ? size_t(std::strtoull(argv[1], nullptr, 10)) : size_t(8) << 30;
+    const size_t threads = argc > 2 ? size_t(std::strtoull(argv[2], nullptr, 10)) : 0;
+
+    std::vector<char> data(max_size);
+    uint64_t state = 1;
+    for(auto& byte : data)
+    {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        byte = static_cast<char>(state >> 56);
+    }
+
+    for(size_t size = size_t(1) << 20; size <= max_size; size <<= 1)
+    {
+        const auto expected = hpp::crc64_fast(data.data(), size);
+        run("hash_impl", size, expected, [&]() { return hpp::hash_impl(data.data(), size, 0); });
+        run("crc64_fast", size, expected, [&]() { return hpp::crc64_fast(data.data(), size); });
+        run("crc64_parallel", size, expected,
+            [&]() { return hpp::crc64_parallel(data.data(), size, threads); });
+    }
+    return 0;
+}
@@ -0,0 +1,172 @@
+// Throughput and latency of hpp::event_bus with many producers.
+//
+//     hpp_event_bus_benchmark [producers] [events per producer] [consumers] [mailbox capacity]
+//
+// Defaults to 8 producers of 200000 events, 1 consumer and 4096 tuple
+// mailboxes. Every producer emits as fast as it can but yields when the bus
+// dropped a tuple, so consumers sharing a core with it get to run. Every
+// consumer dispatches in a loop. The latency is from emit() to the slot
+// call.
+// Build in release with -DBUILD_HPP_BENCHMARKS=ON.
+
+#include <hpp/event_bus.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+
+size_t argument(int argc, char** argv, int index, size_t fallback)
+{
+    return argc > index ? size_t(std::strtoull(argv[index], nullptr, 10)) : fallback;
+}
+
+double percentile(const std::vector<double>& sorted, double fraction)
+{
+    if(sorted.empty())
+    {
+        return 0.0;
+    }
+    return sorted[std::min(sorted.size() - 1, size_t(double(sorted.size()) * fraction))];
+}
+
+void single_thread(size_t capacity)
+{
+    hpp::event_bus<void(int)> bus(capacity);
+    long long sum{};
+    bus.connect(std::this_thread::get_id(),
+                [&sum](int i)
+                {
+                    sum += i;
+                });
+
+    const int frames = 20000;
+    const int per_frame = 100;
+    auto start = clock_type::now();
+    for(int frame = 0; frame < frames; ++frame)
+    {
+        for(int i = 0; i < per_frame; ++i)
+        {
+            bus.emit(i);
+        }
+        bus.dispatch();
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(clock_type::now() - start).count();
+    std::printf("single thread: %.1f ns per emit + dispatch (%lld)\n", elapsed / (frames * per_frame), sum);
+}
+
+void fan_in(size_t producers, size_t events, size_t consumers, size_t capacity)
+{
+    hpp::event_bus<void(size_t, size_t, clock_type::time_point)> bus(capacity);
+    std::atomic<size_t> ready{0};
+    std::atomic<bool> stop{false};
+    std::vector<std::vector<double>> latencies(consumers);
+    std::vector<size_t> delivered(consumers);
+    std::vector<size_t> out_of_order(consumers);
+
+    std::vector<std::thread> consumer_threads;
+    for(size_t c = 0; c < consumers; ++c)
+    {
+        consumer_threads.emplace_back(
+            [&, c]
+            {
+                auto& latency = latencies[c];
+                latency.reserve(producers * events);
+                std::vector<size_t> next(producers);
+                bus.connect(std::this_thread::get_id(),
+                            [&](size_t producer, size_t sequence, clock_type::time_point sent)
+                            {
+                                latency.push_back(
+                                    std::chrono::duration<double, std::micro>(clock_type::now() - sent).count());
+                                if(sequence < next[producer])
+                                {
+                                    out_of_order[c]++;
+                                }
+                                next[producer] = sequence + 1;
+                                delivered[c]++;
+                            });
+                ready++;
+                while(!stop.load())
+                {
+                    if(bus.dispatch() == 0)
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+                bus.dispatch();
+                bus.close();
+            });
+    }
+    while(ready.load() < consumers)
+    {
+        std::this_thread::yield();
+    }
+
+    auto start = clock_type::now();
+    std::vector<std::thread> producer_threads;
+    for(size_t p = 0; p < producers; ++p)
+    {
+        producer_threads.emplace_back(
+            [&bus, p, events]
+            {
+                for(size_t i = 0; i < events; ++i)
+                {
+                    const auto dropped = bus.dropped();
+                    bus.emit(p, i, clock_type::now());
+                    if(bus.dropped() != dropped)
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+    }
+    for(auto& thread : producer_threads)
+    {
+        thread.join();
+    }
+    auto elapsed = std::chrono::duration<double>(clock_type::now() - start).count();
+    stop = true;
+    for(auto& thread : consumer_threads)
+    {
+        thread.join();
+    }
+
+    std::vector<double> all;
+    size_t total{};
+    size_t disorder{};
+    for(size_t c = 0; c < consumers; ++c)
+    {
+        all.insert(all.end(), latencies[c].begin(), latencies[c].end());
+        total += delivered[c];
+        disorder += out_of_order[c];
+    }
+    std::sort(all.begin(), all.end());
+
+    std::printf("%zu producers x %zu events, %zu consumers, mailbox %zu:\n", producers, events, consumers,
+                bus.mailbox_capacity());
+    std::printf("  %.2fM emits/s, delivered %zu, dropped %llu, out of order %zu\n",
+                double(producers * events) / elapsed / 1e6, total, (unsigned long long)bus.dropped(), disorder);
+    std::printf("  latency p50 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us\n", percentile(all, 0.5),
+                percentile(all, 0.99), percentile(all, 0.999), all.empty() ? 0.0 : all.back());
+    std::printf("  hardware threads: %u\n", std::thread::hardware_concurrency());
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const auto producers = argument(argc, argv, 1, 8);
+    const auto events = argument(argc, argv, 2, 200000);
+    const auto consumers = argument(argc, argv, 3, 1);
+    const auto capacity = argument(argc, argv, 4, 4096);
+
+    single_thread(capacity);
+    fan_in(producers, events, consumers, capacity);
+    return 0;
+}
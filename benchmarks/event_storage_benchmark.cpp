@@ -0,0 +1,70 @@
+// event emit cost with tree_slot_storage and contiguous_slot_storage.
+//
+//     hpp_event_storage_benchmark [slot calls per size]
+//
+// Connects 1, 10, 100, 1000 and 10000 slots (a member function of one of
+// 16 listeners each) to an event of each storage mode and times the emits.
+// Defaults to 10M slot calls per size, split over as many emits as that takes.
+// Build in release with -DBUILD_HPP_BENCHMARKS=ON.
+
+#include <hpp/event.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+
+struct listener
+{
+    void on_event(int value)
+    {
+        sum += uint64_t(value);
+    }
+    uint64_t sum{};
+};
+
+template<typename Event>
+void run(const char* name, size_t slot_count, size_t calls)
+{
+    std::vector<listener> listeners(16);
+    Event e;
+    for(size_t i = 0; i < slot_count; ++i)
+    {
+        e.connect(&listeners[i % listeners.size()], &listener::on_event);
+    }
+
+    const auto emits = calls / slot_count;
+    const auto start = clock_type::now();
+    for(size_t i = 0; i < emits; ++i)
+    {
+        e.emit(1);
+    }
+    const auto ns = std::chrono::duration<double, std::nano>(clock_type::now() - start).count();
+
+    uint64_t sum{};
+    for(const auto& l : listeners)
+    {
+        sum += l.sum;
+    }
+    std::printf("%-10s %6zu slots: %7.2f ns/slot call, %10.1f ns/emit%s\n", name, slot_count,
+                ns / double(emits * slot_count), ns / double(emits),
+                sum == emits * slot_count ? "" : " (missed calls)");
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const size_t calls = argc > 1 ? size_t(std::strtoull(argv[1], nullptr, 10)) : 10000000;
+
+    for(size_t slot_count = 1; slot_count <= 10000; slot_count *= 10)
+    {
+        run<hpp::event<void(int)>>("tree", slot_count, calls);
+        run<hpp::contiguous_event<void(int)>>("contiguous", slot_count, calls);
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+// Batched slot_map lookups against one find() per key.
+//
+//     hpp_slot_map_find_many_benchmark [max keys]
+//
+// Defaults to 100M keys, starting at 1M and growing tenfold. Each size fills
+// a slot_map<uint64_t>, shuffles its keys and sums every value once with
+// find(), find_many() and visit_many(). 100M keys need about 3GB of memory.
+// Build in release with -DBUILD_HPP_BENCHMARKS=ON.
+
+#include <hpp/slot_map.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+using map_type = hpp::slot_map<uint64_t>;
+using key_type = map_type::key_type;
+
+// Keys are resolved in batches of this many, the way a caller would gather them.
+constexpr size_t batch_size = 4096;
+
+template<typename Lookup>
+void run(const char* name, const std::vector<key_type>& keys, Lookup&& lookup)
+{
+    const auto start = clock_type::now();
+    const auto sum = lookup();
+    const auto ns = std::chrono::duration<double, std::nano>(clock_type::now() - start).count();
+    std::printf("%-10s %10zu keys: %6.1f ns/key (sum %llu)\n", name, keys.size(), ns / double(keys.size()),
+                static_cast<unsigned long long>(sum));
+}
+
+void run_size(size_t count)
+{
+    map_type map;
+    std::vector<key_type> keys(count);
+    map.emplace_n(keys, uint64_t(1));
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(count));
+
+    run("find", keys,
+        [&]()
+        {
+            uint64_t sum{};
+            for(const auto& key : keys)
+            {
+                auto it = map.find(key);
+                sum += it != map.end() ? *it : 0;
+            }
+            return sum;
+        });
+
+    run("find_many", keys,
+        [&]()
+        {
+            uint64_t sum{};
+            std::vector<uint64_t*> out(batch_size);
+            for(size_t first = 0; first < keys.size(); first += batch_size)
+            {
+                const auto size = (std::min)(batch_size, keys.size() - first);
+                map.find_many(hpp::span<const key_type>(keys.data() + first, size), out);
+                for(size_t i = 0; i < size; ++i)
+                {
+                    sum += out[i] ? *out[i] : 0;
+                }
+            }
+            return sum;
+        });
+
+    run("visit_many", keys,
+        [&]()
+        {
+            uint64_t sum{};
+            map.visit_many(keys, [&sum](size_t, uint64_t value) { sum += value; });
+            return sum;
+        });
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const size_t max_count = argc > 1 ? size_t(std::strtoull(argv[1], nullptr, 10)) : 100000000;
+
+    for(size_t count = 1000000; count <= max_count; count *= 10)
+    {
+        run_size(count);
+    }
+    return 0;
+}
@@ -0,0 +1,71 @@
+// hpp::parallel_for_each over a slot_map at growing thread counts.
+//
+//     hpp_slot_map_parallel_benchmark [values] [max threads]
+//
+// Defaults to 10M values and std::thread::hardware_concurrency() threads.
+// Times a plain loop over the map, then parallel_for_each on pools of 1, 2,
+// 4, ... threads up to the maximum. Every call does a few multiply-adds so
+// the loop is not bound by memory bandwidth alone.
+// Build in release with -DBUILD_HPP_BENCHMARKS=ON.
+
+#include <hpp/slot_map_parallel.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+using map_type = hpp::slot_map<uint64_t>;
+
+void update(uint64_t& value)
+{
+    for(int i = 0; i < 8; ++i)
+    {
+        value = value * 6364136223846793005ull + 1442695040888963407ull;
+    }
+}
+
+template<typename Loop>
+double time_ms(Loop&& loop)
+{
+    const auto start = clock_type::now();
+    loop();
+    return std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const size_t count = argc > 1 ? size_t(std::strtoull(argv[1], nullptr, 10)) : 10000000;
+    const size_t max_threads = argc > 2 ? size_t(std::strtoull(argv[2], nullptr, 10))
+                                        : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+    map_type map;
+    std::vector<map_type::key_type> keys(count);
+    map.emplace_n(keys, uint64_t(1));
+
+    const auto serial = time_ms(
+        [&map]()
+        {
+            for(auto& value : map)
+            {
+                update(value);
+            }
+        });
+    std::printf("serial loop        %9zu values: %8.1f ms\n", count, serial);
+
+    for(size_t threads = 1; threads <= max_threads; threads *= 2)
+    {
+        hpp::work_stealing_pool pool(threads);
+        const auto ms = time_ms([&map, &pool]() { hpp::parallel_for_each(map, update, 4096, pool); });
+        std::printf("parallel %2zu threads %9zu values: %8.1f ms, %5.2fx the serial loop\n", threads, count, ms,
+                    serial / ms);
+    }
+    return 0;
+}
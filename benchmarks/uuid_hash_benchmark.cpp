@@ -0,0 +1,126 @@
+// Unordered container lookups keyed by hpp::uuid.
+//
+//     hpp_uuid_hash_benchmark [keys]
+//
+// Defaults to 10M keys. Fills a std::unordered_set with random (version 4),
+// sequential and equal-halves uuids and times the inserts and one lookup of
+// every key, with hpp::uuid_hash and with the previous hash, which xored the
+// big endian halves. The previous hash sends every equal-halves key to
+// bucket 0, so that pattern is capped at 20k keys for it.
+// Build in release with -DBUILD_HPP_BENCHMARKS=ON.
+
+#include <hpp/uuid.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+
+struct xor_halves_hash
+{
+    size_t operator()(const hpp::uuid& id) const noexcept
+    {
+        const auto data = id.as_bytes();
+        uint64_t l{};
+        uint64_t h{};
+        for(size_t i = 0; i < 8; ++i)
+        {
+            l = l << 8 | uint64_t(data[i]);
+            h = h << 8 | uint64_t(data[i + 8]);
+        }
+        return size_t(l ^ h);
+    }
+};
+
+std::vector<hpp::uuid> random_keys(size_t count)
+{
+    std::vector<hpp::uuid> keys(count);
+    hpp::uuid_fast_random_generator().fill(keys);
+    return keys;
+}
+
+std::vector<hpp::uuid> sequential_keys(size_t count)
+{
+    std::vector<hpp::uuid> keys;
+    keys.reserve(count);
+    for(uint64_t i = 0; i < count; ++i)
+    {
+        std::array<uint8_t, 16> bytes{};
+        for(size_t byte = 0; byte < 8; ++byte)
+        {
+            bytes[15 - byte] = uint8_t(i >> (byte * 8));
+        }
+        keys.emplace_back(bytes);
+    }
+    return keys;
+}
+
+std::vector<hpp::uuid> equal_halves_keys(size_t count)
+{
+    std::vector<hpp::uuid> keys;
+    keys.reserve(count);
+    for(uint64_t i = 0; i < count; ++i)
+    {
+        std::array<uint8_t, 16> bytes{};
+        for(size_t byte = 0; byte < 8; ++byte)
+        {
+            bytes[byte] = bytes[byte + 8] = uint8_t(i >> (byte * 8));
+        }
+        keys.emplace_back(bytes);
+    }
+    return keys;
+}
+
+template<typename Hash>
+void run(const char* hash_name, const char* pattern, const std::vector<hpp::uuid>& keys)
+{
+    std::unordered_set<hpp::uuid, Hash> set;
+    set.reserve(keys.size());
+
+    auto start = clock_type::now();
+    for(const auto& key : keys)
+    {
+        set.insert(key);
+    }
+    auto inserted = clock_type::now();
+
+    size_t found{};
+    for(const auto& key : keys)
+    {
+        found += set.count(key);
+    }
+    auto looked_up = clock_type::now();
+
+    auto ns_per_key = [&keys](clock_type::time_point begin, clock_type::time_point end)
+    {
+        return std::chrono::duration<double, std::nano>(end - begin).count() / double(keys.size());
+    };
+    std::printf("%-10s %-12s %9zu keys: insert %7.1f ns/key, lookup %7.1f ns/key%s\n", hash_name, pattern,
+                keys.size(), ns_per_key(start, inserted), ns_per_key(inserted, looked_up),
+                found == keys.size() ? "" : " (lookup failed)");
+}
+
+template<typename Hash>
+void run_all(const char* hash_name, size_t count, size_t equal_halves_count)
+{
+    run<Hash>(hash_name, "random", random_keys(count));
+    run<Hash>(hash_name, "sequential", sequential_keys(count));
+    run<Hash>(hash_name, "equal halves", equal_halves_keys(equal_halves_count));
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const size_t count = argc > 1 ? size_t(std::strtoull(argv[1], nullptr, 10)) : 10000000;
+
+    run_all<hpp::uuid_hash>("uuid_hash", count, count);
+    run_all<xor_halves_hash>("xor halves", count, (std::min)(count, size_t(20000)));
+    return 0;
+}
@@ -0,0 +1,475 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace hpp
+{
+
+namespace detail
+{
+template <class T>
+T* launder_pointer(T* pointer)
+{
+#if defined(__cpp_lib_launder)
+    return std::launder(pointer);
+#else
+    return pointer;
+#endif
+}
+
+// Largest power of two number of elements that fits in about 16KB, at least 1.
+template <class T>
+constexpr size_t default_chunk_size()
+{
+    size_t count = 1;
+    while(count * 2 * sizeof(T) <= 16384)
+    {
+        count *= 2;
+    }
+    return count;
+}
+} // namespace detail
+
+template <size_t N>
+using chunk_size = std::integral_constant<size_t, N>;
+
+// A vector that stores its elements in fixed size chunks.
+//
+// Growing allocates a new chunk and never moves existing elements, so
+// push_back has no O(n) reallocation step and pointers and references to
+// elements stay valid until the element is erased. Indexing costs one extra
+// indirection through the chunk table.
+//
+// The chunk size is passed as a type (hpp::chunk_size<N>, N a power of two) so
+// the template only has type parameters and can be given to containers that
+// take a `template <class...> class Container`, e.g.
+//
+//     hpp::slot_map<T, Key, hpp::chunked_vector> map;
+//
+//     template <class T>
+//     using small_chunks = hpp::chunked_vector<T, hpp::chunk_size<256>>;
+//     hpp::slot_map<T, Key, small_chunks> map2;
+//
+template <class T, class ChunkSize = chunk_size<detail::default_chunk_size<T>()>>
+class chunked_vector
+{
+    static_assert(ChunkSize::value > 0 && (ChunkSize::value & (ChunkSize::value - 1)) == 0,
+                  "chunk size must be a power of two");
+
+    struct storage_type
+    {
+        alignas(T) unsigned char data[sizeof(T)];
+    };
+
+    struct chunk_deleter
+    {
+        void operator()(storage_type* chunk) const
+        {
+            delete[] chunk;
+        }
+    };
+    using chunk_ptr = std::unique_ptr<storage_type[], chunk_deleter>;
+
+    template <bool Const>
+    class basic_iterator
+    {
+        using owner_type = typename std::conditional<Const, const chunked_vector, chunked_vector>::type;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = typename std::conditional<Const, const T*, T*>::type;
+        using reference = typename std::conditional<Const, const T&, T&>::type;
+
+        basic_iterator() = default;
+        basic_iterator(owner_type* owner, size_t index)
+            : owner_(owner)
+            , index_(index)
+        {
+        }
+        // iterator converts to const_iterator
+        template <bool OtherConst, typename = typename std::enable_if<Const && !OtherConst>::type>
+        basic_iterator(const basic_iterator<OtherConst>& other)
+            : owner_(other.owner_)
+            , index_(other.index_)
+        {
+        }
+
+        reference operator*() const
+        {
+            return (*owner_)[index_];
+        }
+        pointer operator->() const
+        {
+            return &(*owner_)[index_];
+        }
+        reference operator[](difference_type n) const
+        {
+            return (*owner_)[size_t(difference_type(index_) + n)];
+        }
+
+        basic_iterator& operator++()
+        {
+            ++index_;
+            return *this;
+        }
+        basic_iterator operator++(int)
+        {
+            auto result = *this;
+            ++index_;
+            return result;
+        }
+        basic_iterator& operator--()
+        {
+            --index_;
+            return *this;
+        }
+        basic_iterator operator--(int)
+        {
+            auto result = *this;
+            --index_;
+            return result;
+        }
+        basic_iterator& operator+=(difference_type n)
+        {
+            index_ = size_t(difference_type(index_) + n);
+            return *this;
+        }
+        basic_iterator& operator-=(difference_type n)
+        {
+            index_ = size_t(difference_type(index_) - n);
+            return *this;
+        }
+        friend basic_iterator operator+(basic_iterator it, difference_type n)
+        {
+            return it += n;
+        }
+        friend basic_iterator operator+(difference_type n, basic_iterator it)
+        {
+            return it += n;
+        }
+        friend basic_iterator operator-(basic_iterator it, difference_type n)
+        {
+            return it -= n;
+        }
+        friend difference_type operator-(const basic_iterator& lhs, const basic_iterator& rhs)
+        {
+            return difference_type(lhs.index_) - difference_type(rhs.index_);
+        }
+
+        friend bool operator==(const basic_iterator& lhs, const basic_iterator& rhs)
+        {
+            return lhs.index_ == rhs.index_;
+        }
+        friend bool operator!=(const basic_iterator& lhs, const basic_iterator& rhs)
+        {
+            return lhs.index_ != rhs.index_;
+        }
+        friend bool operator<(const basic_iterator& lhs, const basic_iterator& rhs)
+        {
+            return lhs.index_ < rhs.index_;
+        }
+        friend bool operator>(const basic_iterator& lhs, const basic_iterator& rhs)
+        {
+            return lhs.index_ > rhs.index_;
+        }
+        friend bool operator<=(const basic_iterator& lhs, const basic_iterator& rhs)
+        {
+            return lhs.index_ <= rhs.index_;
+        }
+        friend bool operator>=(const basic_iterator& lhs, const basic_iterator& rhs)
+        {
+            return lhs.index_ >= rhs.index_;
+        }
+
+    private:
+        friend class chunked_vector;
+        friend class basic_iterator<!Const>;
+
+        owner_type* owner_{};
+        size_t index_{};
+    };
+
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    static constexpr size_type elements_per_chunk = ChunkSize::value;
+
+    chunked_vector() = default;
+    chunked_vector(const chunked_vector& other)
+    {
+        reserve(other.size());
+        try
+        {
+            for(const auto& value : other)
+            {
+                emplace_back(value);
+            }
+        }
+        catch(...)
+        {
+            // The destructor does not run for a constructor that throws.
+            clear();
+            chunks_.clear();
+            throw;
+        }
+    }
+    chunked_vector(chunked_vector&& other) noexcept
+        : chunks_(std::move(other.chunks_))
+        , size_(other.size_)
+    {
+        other.size_ = 0;
+    }
+    chunked_vector& operator=(const chunked_vector& other)
+    {
+        if(this != &other)
+        {
+            chunked_vector copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+    chunked_vector& operator=(chunked_vector&& other) noexcept
+    {
+        if(this != &other)
+        {
+            clear();
+            chunks_ = std::move(other.chunks_);
+            size_ = other.size_;
+            other.size_ = 0;
+        }
+        return *this;
+    }
+    ~chunked_vector()
+    {
+        clear();
+    }
+
+    reference operator[](size_type index)
+    {
+        return *element(index);
+    }
+    const_reference operator[](size_type index) const
+    {
+        return *element(index);
+    }
+    reference at(size_type index)
+    {
+        if(index >= size_)
+        {
+            throw std::out_of_range("chunked_vector::at");
+        }
+        return *element(index);
+    }
+    const_reference at(size_type index) const
+    {
+        if(index >= size_)
+        {
+            throw std::out_of_range("chunked_vector::at");
+        }
+        return *element(index);
+    }
+    reference front()
+    {
+        return *element(0);
+    }
+    const_reference front() const
+    {
+        return *element(0);
+    }
+    reference back()
+    {
+        return *element(size_ - 1);
+    }
+    const_reference back() const
+    {
+        return *element(size_ - 1);
+    }
+
+    iterator begin()
+    {
+        return iterator(this, 0);
+    }
+    iterator end()
+    {
+        return iterator(this, size_);
+    }
+    const_iterator begin() const
+    {
+        return const_iterator(this, 0);
+    }
+    const_iterator end() const
+    {
+        return const_iterator(this, size_);
+    }
+    const_iterator cbegin() const
+    {
+        return begin();
+    }
+    const_iterator cend() const
+    {
+        return end();
+    }
+    reverse_iterator rbegin()
+    {
+        return reverse_iterator(end());
+    }
+    reverse_iterator rend()
+    {
+        return reverse_iterator(begin());
+    }
+    const_reverse_iterator rbegin() const
+    {
+        return const_reverse_iterator(end());
+    }
+    const_reverse_iterator rend() const
+    {
+        return const_reverse_iterator(begin());
+    }
+    const_reverse_iterator crbegin() const
+    {
+        return rbegin();
+    }
+    const_reverse_iterator crend() const
+    {
+        return rend();
+    }
+
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+    size_type size() const
+    {
+        return size_;
+    }
+    size_type capacity() const
+    {
+        return chunks_.size() * elements_per_chunk;
+    }
+    // Allocates chunks up front. Existing elements are not touched.
+    void reserve(size_type n)
+    {
+        const auto needed = (n + elements_per_chunk - 1) / elements_per_chunk;
+        if(needed <= chunks_.size())
+        {
+            return;
+        }
+        chunks_.reserve(needed);
+        while(chunks_.size() < needed)
+        {
+            chunks_.emplace_back(new storage_type[elements_per_chunk]);
+        }
+    }
+    // Frees the chunks past the one holding the last element.
+    void shrink_to_fit()
+    {
+        chunks_.resize((size_ + elements_per_chunk - 1) / elements_per_chunk);
+        chunks_.shrink_to_fit();
+    }
+
+    template <typename... Args>
+    reference emplace_back(Args&&... args)
+    {
+        if(size_ == capacity())
+        {
+            chunks_.emplace_back(new storage_type[elements_per_chunk]);
+        }
+        auto value = ::new(static_cast<void*>(element(size_))) T(std::forward<Args>(args)...);
+        ++size_;
+        return *value;
+    }
+    void push_back(const T& value)
+    {
+        emplace_back(value);
+    }
+    void push_back(T&& value)
+    {
+        emplace_back(std::move(value));
+    }
+    void pop_back()
+    {
+        --size_;
+        element(size_)->~T();
+    }
+
+    // Elements after the erased range are moved down, like std::vector.
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        const auto first_index = first.index_;
+        const auto count = last.index_ - first.index_;
+        if(count > 0)
+        {
+            for(auto index = first_index; index + count < size_; ++index)
+            {
+                *element(index) = std::move(*element(index + count));
+            }
+            for(size_type i = 0; i < count; ++i)
+            {
+                pop_back();
+            }
+        }
+        return iterator(this, first_index);
+    }
+    iterator erase(const_iterator pos)
+    {
+        return erase(pos, std::next(pos));
+    }
+
+    // Destroys all elements but keeps the chunks.
+    void clear()
+    {
+        while(size_ > 0)
+        {
+            pop_back();
+        }
+    }
+
+    void swap(chunked_vector& other) noexcept
+    {
+        using std::swap;
+        swap(chunks_, other.chunks_);
+        swap(size_, other.size_);
+    }
+
+private:
+    T* element(size_type index)
+    {
+        return detail::launder_pointer(
+            reinterpret_cast<T*>(chunks_[index / elements_per_chunk][index % elements_per_chunk].data));
+    }
+    const T* element(size_type index) const
+    {
+        return detail::launder_pointer(
+            reinterpret_cast<const T*>(chunks_[index / elements_per_chunk][index % elements_per_chunk].data));
+    }
+
+    std::vector<chunk_ptr> chunks_;
+    size_type size_{};
+};
+
+template <class T, class ChunkSize>
+void swap(chunked_vector<T, ChunkSize>& lhs, chunked_vector<T, ChunkSize>& rhs) noexcept
+{
+    lhs.swap(rhs);
+}
+
+} // namespace hpp
@@ -0,0 +1,422 @@
+#pragma once
+#include "delegate.hpp"
+#include "optional.hpp"
+#include "sentinel.hpp"
+#include "source_location.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace hpp
+{
+template<typename T>
+class concurrent_event;
+
+/// An event that can be emitted from any number of threads while other
+/// threads connect and disconnect slots.
+///
+/// The slots live in an immutable, priority sorted list. emit() takes no
+/// lock: it registers itself as a reader of the current epoch, loads the
+/// list and calls the slots. connect() and disconnect() copy the list under
+/// a writer mutex and publish the copy with one atomic store. A replaced list
+/// is freed only once every emit that could still be reading it returned,
+/// so writers never wait for readers and slots may connect and disconnect
+/// while being emitted.
+///
+/// Like event, a slot that is disconnected (or whose sentinel expired)
+/// while an emit is running is not called by it anymore, and slots with an
+/// expired sentinel are removed from the list after the emit. A slot
+/// connected during an emit is called from the next emit on.
+template<typename... Args>
+class concurrent_event<void(Args...)>
+{
+public:
+    using slot_type = delegate<void(Args...)>;
+    using slot_key = uint64_t;
+    using slot_sentinel = hpp::optional<hpp::sentinel>;
+    using slot_priority = int64_t;
+
+    concurrent_event() = default;
+    concurrent_event(const concurrent_event&) = delete;
+    concurrent_event& operator=(const concurrent_event&) = delete;
+
+    /// No emit may be running.
+    ~concurrent_event()
+    {
+        delete current_.load(std::memory_order_relaxed);
+        for(auto& retired : retired_)
+        {
+            for(auto list : retired)
+            {
+                delete list;
+            }
+        }
+    }
+
+    template<class C>
+    slot_key connect(C* const object_ptr,
+                     void (C::*const method_ptr)(Args...),
+                     const hpp::source_location& location = hpp::source_location::current())
+    {
+        return connect_impl(hpp::nullopt, slot_priority(0), location, slot_type(object_ptr, method_ptr));
+    }
+
+    template<class C>
+    slot_key connect(C* const object_ptr,
+                     void (C::*const method_ptr)(Args...) const,
+                     const hpp::source_location& location = hpp::source_location::current())
+    {
+        return connect_impl(hpp::nullopt, slot_priority(0), location, slot_type(object_ptr, method_ptr));
+    }
+
+    template<typename T,
+             typename = typename std::enable_if<
+                 !std::is_same<concurrent_event, typename std::decay<T>::type>::value>::type>
+    slot_key connect(T&& f, const hpp::source_location& location = hpp::source_location::current())
+    {
+        return connect_impl(hpp::nullopt, slot_priority(0), location, slot_type(std::forward<T>(f)));
+    }
+
+    template<typename T>
+    slot_key connect(slot_priority priority,
+                     T&& f,
+                     const hpp::source_location& location = hpp::source_location::current())
+    {
+        return connect_impl(hpp::nullopt, priority, location, slot_type(std::forward<T>(f)));
+    }
+
+    template<typename T>
+    slot_key connect(const slot_sentinel& sentinel,
+                     T&& f,
+                     const hpp::source_location& location = hpp::source_location::current())
+    {
+        return connect_impl(sentinel, slot_priority(0), location, slot_type(std::forward<T>(f)));
+    }
+
+    template<typename T>
+    slot_key connect(const slot_sentinel& sentinel,
+                     slot_priority priority,
+                     T&& f,
+                     const hpp::source_location& location = hpp::source_location::current())
+    {
+        return connect_impl(sentinel, priority, location, slot_type(std::forward<T>(f)));
+    }
+
+    template<class C>
+    void disconnect(C* const object_ptr, void (C::*const method_ptr)(Args...))
+    {
+        disconnect_impl(slot_type(object_ptr, method_ptr));
+    }
+
+    template<class C>
+    void disconnect(C* const object_ptr, void (C::*const method_ptr)(Args...) const)
+    {
+        disconnect_impl(slot_type(object_ptr, method_ptr));
+    }
+
+    void disconnect(const slot_key& key)
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        publish_without(
+            [&key](const slot_state& state)
+            {
+                return state.key == key;
+            },
+            true);
+    }
+
+    void disconnect_all()
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        publish_without(
+            [](const slot_state&)
+            {
+                return true;
+            },
+            false);
+    }
+
+    /// Disconnects the slot of this event this thread is currently calling,
+    /// also from inside an emit of another event that the slot started.
+    void disconnect_current()
+    {
+        for(auto scope = innermost_scope(); scope != nullptr; scope = scope->outer)
+        {
+            if(scope->owner == this)
+            {
+                if(scope->key != slot_key{})
+                {
+                    disconnect(scope->key);
+                }
+                return;
+            }
+        }
+    }
+
+    /// Emits the events you wish to send to the call-backs
+    /// \param args The arguments to emit to the slots connected to the signal
+    void emit(Args... args) const
+    {
+        read_scope scope(*this);
+        if(scope.list == nullptr)
+        {
+            return;
+        }
+
+        current_scope current(this);
+        bool collect_garbage{};
+        for(const auto& state : scope.list->slots)
+        {
+            current.key = state->key;
+
+            if(check_for_remove(*state))
+            {
+                collect_garbage = true;
+                continue;
+            }
+
+            state->slot(args...);
+
+            if(check_for_remove(*state))
+            {
+                collect_garbage = true;
+            }
+        }
+
+        if(collect_garbage)
+        {
+            std::lock_guard<std::mutex> lock(write_mutex_);
+            publish_without(
+                [](const slot_state& state)
+                {
+                    return state.removed.load(std::memory_order_relaxed);
+                },
+                false);
+        }
+    }
+
+    void operator()(Args... args) const
+    {
+        emit(args...);
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    /// Number of slots in the current list.
+    size_t size() const
+    {
+        read_scope scope(*this);
+        return scope.list == nullptr ? 0 : scope.list->slots.size();
+    }
+
+private:
+    struct slot_state
+    {
+        slot_key key{};
+        slot_priority priority{};
+        slot_type slot{};
+        slot_sentinel sentinel = hpp::nullopt;
+        hpp::source_location location = hpp::source_location::current();
+        /// Shared by every list holding the slot, so running emits see it.
+        mutable std::atomic<bool> removed{false};
+    };
+
+    struct slot_list
+    {
+        std::vector<std::shared_ptr<slot_state>> slots;
+    };
+
+    /// Registers an emit as a reader of the current epoch. Lists retired
+    /// during an epoch are freed once the epoch has no readers left.
+    struct read_scope
+    {
+        read_scope(const concurrent_event& owner)
+            : owner_(owner)
+        {
+            for(;;)
+            {
+                epoch_ = owner_.epoch_.load(std::memory_order_seq_cst);
+                owner_.readers_[epoch_ & 1].fetch_add(1, std::memory_order_seq_cst);
+                if(owner_.epoch_.load(std::memory_order_seq_cst) == epoch_)
+                {
+                    break;
+                }
+                owner_.readers_[epoch_ & 1].fetch_sub(1, std::memory_order_seq_cst);
+            }
+            list = owner_.current_.load(std::memory_order_seq_cst);
+        }
+        ~read_scope()
+        {
+            owner_.readers_[epoch_ & 1].fetch_sub(1, std::memory_order_seq_cst);
+        }
+
+        const concurrent_event& owner_;
+        uint32_t epoch_{};
+        const slot_list* list{};
+    };
+
+    /// The slot an emit on this thread is calling. The scopes of nested
+    /// emits are linked innermost first, keys are only unique per event.
+    struct current_scope
+    {
+        current_scope(const concurrent_event* owner_event)
+            : owner(owner_event)
+            , outer(innermost_scope())
+        {
+            innermost_scope() = this;
+        }
+        ~current_scope()
+        {
+            innermost_scope() = outer;
+        }
+        current_scope(const current_scope&) = delete;
+        current_scope& operator=(const current_scope&) = delete;
+
+        const concurrent_event* owner;
+        current_scope* outer;
+        slot_key key{};
+    };
+
+    static current_scope*& innermost_scope()
+    {
+        thread_local current_scope* scope{};
+        return scope;
+    }
+
+    static bool check_for_remove(const slot_state& state)
+    {
+        if(state.removed.load(std::memory_order_acquire))
+        {
+            return true;
+        }
+
+        if(state.sentinel != hpp::nullopt && state.sentinel.value().expired())
+        {
+            state.removed.store(true, std::memory_order_release);
+            return true;
+        }
+
+        return false;
+    }
+
+    slot_key connect_impl(const slot_sentinel& sentinel,
+                          slot_priority priority,
+                          const hpp::source_location& location,
+                          slot_type&& slot)
+    {
+        auto state = std::make_shared<slot_state>();
+        state->priority = priority;
+        state->slot = std::move(slot);
+        state->sentinel = sentinel;
+        state->location = location;
+
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        state->key = free_id_++;
+        auto key = state->key;
+
+        std::unique_ptr<slot_list> list(new slot_list);
+        auto current = current_.load(std::memory_order_relaxed);
+        if(current != nullptr)
+        {
+            list->slots.reserve(current->slots.size() + 1);
+            list->slots.assign(std::begin(current->slots), std::end(current->slots));
+        }
+        // after the slots of the same priority, like event
+        auto it = std::upper_bound(std::begin(list->slots),
+                                   std::end(list->slots),
+                                   priority,
+                                   [](slot_priority p, const std::shared_ptr<slot_state>& element)
+                                   {
+                                       return p > element->priority;
+                                   });
+        list->slots.insert(it, std::move(state));
+        publish(std::move(list));
+        return key;
+    }
+
+    void disconnect_impl(const slot_type& slot)
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        publish_without(
+            [&slot](const slot_state& state)
+            {
+                return !state.removed.load(std::memory_order_relaxed) && state.slot == slot;
+            },
+            true);
+    }
+
+    /// Publishes a copy of the list without the matching slots, only the
+    /// first one if first_only. write_mutex_ must be held.
+    template<typename Predicate>
+    void publish_without(Predicate predicate, bool first_only) const
+    {
+        auto current = current_.load(std::memory_order_relaxed);
+        if(current == nullptr)
+        {
+            return;
+        }
+
+        std::unique_ptr<slot_list> list(new slot_list);
+        list->slots.reserve(current->slots.size());
+        bool found{};
+        for(const auto& state : current->slots)
+        {
+            if((!found || !first_only) && predicate(*state))
+            {
+                found = true;
+                // running emits skip it from now on
+                state->removed.store(true, std::memory_order_release);
+                continue;
+            }
+            list->slots.push_back(state);
+        }
+
+        if(found)
+        {
+            publish(std::move(list));
+        }
+    }
+
+    /// write_mutex_ must be held.
+    void publish(std::unique_ptr<slot_list> list) const
+    {
+        auto old = current_.exchange(list.release(), std::memory_order_seq_cst);
+        const auto epoch = epoch_.load(std::memory_order_relaxed);
+        if(old != nullptr)
+        {
+            retired_[epoch & 1].push_back(old);
+        }
+
+        // Emits that started before the last epoch change may still read
+        // the lists retired before it. Once they are done those lists can go
+        // and the epoch can advance.
+        auto& previous = retired_[(epoch + 1) & 1];
+        if(readers_[(epoch + 1) & 1].load(std::memory_order_seq_cst) == 0)
+        {
+            for(auto retired : previous)
+            {
+                delete retired;
+            }
+            previous.clear();
+            epoch_.store(epoch + 1, std::memory_order_seq_cst);
+        }
+    }
+
+    mutable std::atomic<const slot_list*> current_{nullptr};
+    mutable std::atomic<uint32_t> epoch_{0};
+    mutable std::atomic<size_t> readers_[2]{};
+
+    mutable std::mutex write_mutex_;
+    /// Replaced lists by the parity of the epoch they were replaced in
+    mutable std::vector<const slot_list*> retired_[2];
+    slot_key free_id_ = 1;
+};
+
+} // end of namespace hpp
@@ -0,0 +1,467 @@
+#pragma once
+
+#include "optional.hpp"
+#include "slot_map.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace hpp
+{
+
+// A slot_map for many readers and a few writers.
+//
+// Keys are (index, generation) pairs just like slot_map keys and are checked
+// the same way, but values never move: each slot lives in a fixed page and
+// is guarded by a sequence lock. find() never blocks or writes shared memory,
+// it copies the value out and retries if a writer touched the slot meanwhile.
+// That copy is why T must be trivially copyable.
+//
+// Writers only contend on the slot they modify. Free slot indices are kept in
+// sharded free lists, each thread takes from and returns to its own shard.
+// A thread whose shard is empty steals from the other shards before taking
+// never used slots, so a thread that only inserts reuses the slots erased by
+// other threads.
+//
+// There is no dense value array, so unlike slot_map there is no iteration.
+//
+// A slot generation is odd while the slot holds a value, and even while it is
+// free. A slot whose next generation would not fit the key's generation type
+// is retired instead of reused, like an exhausted slot_map slot, so a key is
+// never confused with a newer one.
+//
+// Keys are read through slot_map_key_traits, so the packed keys of slot_map
+// (packed_key32, packed_key64) work here too.
+//
+template <class T, class Key = std::pair<unsigned, unsigned>>
+class concurrent_slot_map
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "concurrent_slot_map readers copy values while writers may modify them");
+
+    using key_traits = slot_map_key_traits<Key>;
+
+    static auto get_index(const Key& k)
+    {
+        return key_traits::get_index(k);
+    }
+    static auto get_generation(const Key& k)
+    {
+        return key_traits::get_generation(k);
+    }
+
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using size_type = size_t;
+
+    using key_size_type = decltype(get_index(std::declval<Key>()));
+    using key_generation_type = decltype(get_generation(std::declval<Key>()));
+
+    static constexpr size_type page_size = 4096;
+    static constexpr size_type shard_count = 16;
+
+    // max_slots bounds the number of values alive at once, it is capped by
+    // the index range of the key. Only the page table (one pointer per
+    // page_size slots) is allocated up front.
+    explicit concurrent_slot_map(size_type max_slots = size_type(1) << 24)
+        : max_slots_((std::min)(max_slots, size_type(key_traits::max_slots())))
+        , page_count_((max_slots_ + page_size - 1) / page_size)
+        , pages_(new std::atomic<slot*>[page_count_])
+    {
+        for(size_type i = 0; i < page_count_; ++i)
+        {
+            pages_[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    concurrent_slot_map(const concurrent_slot_map&) = delete;
+    concurrent_slot_map& operator=(const concurrent_slot_map&) = delete;
+
+    ~concurrent_slot_map()
+    {
+        for(size_type i = 0; i < page_count_; ++i)
+        {
+            delete[] pages_[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    // Copies the value for key into out. Lock free.
+    // Returns false if the key is stale or was never handed out.
+    bool load(const key_type& key, mapped_type& out) const
+    {
+        auto s = find_slot(key);
+        if(s == nullptr)
+        {
+            return false;
+        }
+
+        const auto expected = live_sequence(get_generation(key));
+        for(;;)
+        {
+            auto before = s->sequence.load(std::memory_order_acquire);
+            if(before != expected)
+            {
+                if(before == (expected | 1))
+                {
+                    // a writer is updating this value, wait for it
+                    continue;
+                }
+                return false;
+            }
+
+            std::memcpy(static_cast<void*>(&out), &s->storage, sizeof(mapped_type));
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if(s->sequence.load(std::memory_order_relaxed) == before)
+            {
+                return true;
+            }
+        }
+    }
+
+    // Lock free, see load().
+    optional<mapped_type> find(const key_type& key) const
+    {
+        alignas(mapped_type) unsigned char buffer[sizeof(mapped_type)];
+        auto& value = *reinterpret_cast<mapped_type*>(buffer);
+        if(!load(key, value))
+        {
+            return nullopt;
+        }
+        return value;
+    }
+
+    bool contains(const key_type& key) const
+    {
+        auto s = find_slot(key);
+        return s != nullptr && (s->sequence.load(std::memory_order_acquire) & ~uint64_t(1)) ==
+                                   live_sequence(get_generation(key));
+    }
+
+    // Replaces the value of a live key. Returns false if the key is stale.
+    bool store(const key_type& key, const mapped_type& value)
+    {
+        auto s = find_slot(key);
+        if(s == nullptr)
+        {
+            return false;
+        }
+
+        const auto expected = live_sequence(get_generation(key));
+        if(!lock_slot(*s, expected))
+        {
+            return false;
+        }
+        std::memcpy(static_cast<void*>(&s->storage), &value, sizeof(mapped_type));
+        s->sequence.store(expected, std::memory_order_release);
+        return true;
+    }
+
+    key_type insert(const mapped_type& value)
+    {
+        return this->emplace(value);
+    }
+
+    // Throws std::length_error when all max_slots slots are in use.
+    template <typename... Args>
+    key_type emplace(Args&&... args)
+    {
+        auto index = acquire_index();
+        auto& s = get_slot(index);
+
+        // the slot is free and owned by this thread, so no one else writes it
+        const auto free_sequence = s.sequence.load(std::memory_order_relaxed);
+        s.sequence.store(free_sequence | 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        try
+        {
+            ::new(static_cast<void*>(&s.storage)) mapped_type(std::forward<Args>(args)...);
+        }
+        catch(...)
+        {
+            s.sequence.store(free_sequence, std::memory_order_release);
+            release_index(index);
+            throw;
+        }
+
+        const auto generation = key_generation_type((free_sequence >> 1) + 1);
+        s.sequence.store(live_sequence(generation), std::memory_order_release);
+        size_.fetch_add(1, std::memory_order_relaxed);
+
+        return key_type{key_size_type(index), generation};
+    }
+
+    // Returns the number of erased values, 0 or 1, like slot_map::erase(key).
+    size_type erase(const key_type& key)
+    {
+        auto s = find_slot(key);
+        if(s == nullptr)
+        {
+            return 0;
+        }
+
+        const auto expected = live_sequence(get_generation(key));
+        if(!lock_slot(*s, expected))
+        {
+            return 0;
+        }
+        // T is trivially destructible, expiring the generation is enough
+        s->sequence.store(expected + 2, std::memory_order_release);
+        size_.fetch_sub(1, std::memory_order_relaxed);
+
+        if(!is_exhausted(key))
+        {
+            release_index(get_index(key));
+        }
+        return 1;
+    }
+
+    // Approximate while writers are active.
+    size_type size() const
+    {
+        return size_.load(std::memory_order_relaxed);
+    }
+    bool empty() const
+    {
+        return size() == 0;
+    }
+    size_type max_slots() const
+    {
+        return max_slots_;
+    }
+
+private:
+    struct slot
+    {
+        // generation * 2, plus one while a writer holds the slot
+        std::atomic<uint64_t> sequence{0};
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    struct alignas(64) shard
+    {
+        std::mutex mutex;
+        std::vector<size_type> free;
+        // free.size(), readable without the mutex so that stealing skips
+        // empty shards without locking them
+        std::atomic<size_type> available{0};
+    };
+
+    // Fresh indices are handed to shards in batches. page_size is a multiple
+    // of it so a batch never spans two pages.
+    static constexpr size_type batch_size = 64;
+
+    // Sequence of a slot holding generation. Keys with an even generation
+    // were never handed out and get a sequence no slot can reach.
+    static uint64_t live_sequence(key_generation_type generation)
+    {
+        if((uint64_t(generation) & 1) == 0)
+        {
+            return ~uint64_t(1);
+        }
+        return uint64_t(generation) << 1;
+    }
+
+    // True if the slot of a live key has no next live generation, the slot
+    // is then retired when erased. The key traits wrap the generation within
+    // the bits the key has for it.
+    static bool is_exhausted(const key_type& key)
+    {
+        auto next = key;
+        key_traits::increment_generation(next);
+        key_traits::increment_generation(next);
+        return uint64_t(get_generation(next)) < uint64_t(get_generation(key));
+    }
+
+    const slot* find_slot(const key_type& key) const
+    {
+        const auto index = size_type(get_index(key));
+        const auto page = index / page_size;
+        if(page >= page_count_)
+        {
+            return nullptr;
+        }
+        auto slots = pages_[page].load(std::memory_order_acquire);
+        if(slots == nullptr)
+        {
+            return nullptr;
+        }
+        return slots + index % page_size;
+    }
+    slot* find_slot(const key_type& key)
+    {
+        return const_cast<slot*>(static_cast<const concurrent_slot_map*>(this)->find_slot(key));
+    }
+
+    slot& get_slot(size_type index)
+    {
+        return pages_[index / page_size].load(std::memory_order_acquire)[index % page_size];
+    }
+
+    // Takes the writer lock of a live slot, waiting for other writers.
+    // Fails if the slot no longer holds the expected generation.
+    static bool lock_slot(slot& s, uint64_t expected)
+    {
+        for(;;)
+        {
+            auto current = expected;
+            if(s.sequence.compare_exchange_weak(current, expected | 1, std::memory_order_acquire,
+                                                std::memory_order_relaxed))
+            {
+                std::atomic_thread_fence(std::memory_order_release);
+                return true;
+            }
+            if(current != expected && current != (expected | 1))
+            {
+                return false;
+            }
+        }
+    }
+
+    shard& local_shard()
+    {
+        static std::atomic<size_type> next_thread{0};
+        thread_local const size_type thread_shard =
+            next_thread.fetch_add(1, std::memory_order_relaxed) % shard_count;
+        return shards_[thread_shard];
+    }
+
+    size_type acquire_index()
+    {
+        auto& own = local_shard();
+        {
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if(!own.free.empty())
+            {
+                return pop_free(own);
+            }
+        }
+
+        // Reuse the slots erased by other threads before using fresh ones.
+        size_type index;
+        if(steal(own, index))
+        {
+            return index;
+        }
+        {
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if(own.free.empty())
+            {
+                refill(own.free);
+            }
+            if(!own.free.empty())
+            {
+                return pop_free(own);
+            }
+        }
+        // out of fresh slots, other threads may have erased some meanwhile
+        if(steal(own, index))
+        {
+            return index;
+        }
+
+        SLOT_MAP_THROW_EXCEPTION(std::length_error, "concurrent_slot_map is full");
+    }
+
+    // Takes one index and half of the rest of another shard's free list.
+    // Only one shard mutex is held at a time, two threads stealing from each
+    // other's shards would deadlock otherwise.
+    bool steal(shard& own, size_type& index)
+    {
+        for(auto& other : shards_)
+        {
+            if(&other == &own || other.available.load(std::memory_order_relaxed) == 0)
+            {
+                continue;
+            }
+
+            std::vector<size_type> stolen;
+            {
+                std::lock_guard<std::mutex> lock(other.mutex);
+                if(other.free.empty())
+                {
+                    continue;
+                }
+                index = pop_free(other);
+
+                const auto half = other.free.size() / 2;
+                stolen.assign(other.free.end() - half, other.free.end());
+                other.free.resize(other.free.size() - half);
+                other.available.store(other.free.size(), std::memory_order_relaxed);
+            }
+
+            if(!stolen.empty())
+            {
+                std::lock_guard<std::mutex> lock(own.mutex);
+                own.free.insert(own.free.end(), stolen.begin(), stolen.end());
+                own.available.store(own.free.size(), std::memory_order_relaxed);
+            }
+            return true;
+        }
+        return false;
+    }
+
+    // Called with the shard mutex held.
+    static size_type pop_free(shard& s)
+    {
+        auto index = s.free.back();
+        s.free.pop_back();
+        s.available.store(s.free.size(), std::memory_order_relaxed);
+        return index;
+    }
+
+    void release_index(size_type index)
+    {
+        auto& own = local_shard();
+        std::lock_guard<std::mutex> lock(own.mutex);
+        own.free.push_back(index);
+        own.available.store(own.free.size(), std::memory_order_relaxed);
+    }
+
+    // Appends a batch of never used indices, allocating their page if needed.
+    void refill(std::vector<size_type>& free)
+    {
+        const auto first = next_fresh_.fetch_add(batch_size, std::memory_order_relaxed);
+        if(first >= max_slots())
+        {
+            return;
+        }
+        const auto last = (std::min)(first + batch_size, max_slots());
+
+        const auto page = first / page_size;
+        if(pages_[page].load(std::memory_order_acquire) == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(page_mutex_);
+            if(pages_[page].load(std::memory_order_relaxed) == nullptr)
+            {
+                pages_[page].store(new slot[page_size], std::memory_order_release);
+            }
+        }
+
+        // reversed so that indices are handed out in increasing order
+        for(auto index = last; index > first; --index)
+        {
+            free.push_back(index - 1);
+        }
+    }
+
+    const size_type max_slots_;
+    const size_type page_count_;
+    std::unique_ptr<std::atomic<slot*>[]> pages_;
+    std::mutex page_mutex_;
+    std::atomic<size_type> next_fresh_{0};
+    std::atomic<size_type> size_{0};
+    shard shards_[shard_count];
+};
+
+} // namespace hpp
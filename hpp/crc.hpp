@@ -1,5 +1,8 @@
 #pragma once
 
+#include "detail/cpu_features.hpp"
+#include "span.hpp"
+#include <cstddef>
 #include <cstdint>
 
 namespace hpp
@@ -279,4 +282,281 @@ inline constexpr auto crc64(const char* data, size_t size) -> uint64_t
     return hash_impl(data, size, 0);
 }
 
+namespace detail
+{
+
+struct crc64_slice_tables
+{
+    uint64_t data[8][256]{};
+};
+
+inline constexpr auto make_crc64_slice_tables() -> crc64_slice_tables
+{
+    crc64_slice_tables tables{};
+    for(size_t n = 0; n < 256; ++n)
+    {
+        tables.data[0][n] = s_Table64[n];
+    }
+    for(size_t k = 1; k < 8; ++k)
+    {
+        for(size_t n = 0; n < 256; ++n)
+        {
+            const auto prev = tables.data[k - 1][n];
+            tables.data[k][n] = (prev >> 8) ^ s_Table64[prev & 0xff];
+        }
+    }
+    return tables;
+}
+
+inline auto get_crc64_slice_tables() -> const crc64_slice_tables&
+{
+    static constexpr crc64_slice_tables tables = make_crc64_slice_tables();
+    return tables;
+}
+
+inline auto load_u64_le(const char* data) -> uint64_t
+{
+    const auto* p = reinterpret_cast<const unsigned char*>(data);
+    return uint64_t(p[0]) | uint64_t(p[1]) << 8 | uint64_t(p[2]) << 16 | uint64_t(p[3]) << 24 |
+           uint64_t(p[4]) << 32 | uint64_t(p[5]) << 40 | uint64_t(p[6]) << 48 | uint64_t(p[7]) << 56;
+}
+
+// Slicing-by-8: consumes 8 bytes per iteration with 8 independent table lookups.
+inline auto hash_impl_slice8(const char* data, size_t size, uint64_t crc) -> uint64_t
+{
+    const auto& t = get_crc64_slice_tables().data;
+    for(; size >= 8; size -= 8, data += 8)
+    {
+        crc ^= load_u64_le(data);
+        crc = t[7][crc & 0xff] ^ t[6][(crc >> 8) & 0xff] ^ t[5][(crc >> 16) & 0xff] ^
+              t[4][(crc >> 24) & 0xff] ^ t[3][(crc >> 32) & 0xff] ^ t[2][(crc >> 40) & 0xff] ^
+              t[1][(crc >> 48) & 0xff] ^ t[0][crc >> 56];
+    }
+    return hash_impl(data, size, crc);
+}
+
+// x^n mod P in the reflected bit order used by the table driven implementation
+// (bit i holds the coefficient of x^(63 - i)).
+inline constexpr auto crc64_xpow_mod(size_t n) -> uint64_t
+{
+    uint64_t result = uint64_t(1) << 63;
+    for(size_t i = 0; i < n; ++i)
+    {
+        const bool carry = (result & 1) != 0;
+        result >>= 1;
+        if(carry)
+        {
+            result ^= s_Table64[128];
+        }
+    }
+    return result;
+}
+
+// a * b mod P, both operands in the reflected bit order.
+inline constexpr auto crc64_multmod(uint64_t a, uint64_t b) -> uint64_t
+{
+    uint64_t m = uint64_t(1) << 63;
+    uint64_t p = 0;
+    for(;;)
+    {
+        if(a & m)
+        {
+            p ^= b;
+            if((a & (m - 1)) == 0)
+            {
+                break;
+            }
+        }
+        m >>= 1;
+        b = (b & 1) ? (b >> 1) ^ s_Table64[128] : b >> 1;
+    }
+    return p;
+}
+
+struct crc64_x2n_table
+{
+    // data[k] = x^(2^k) mod P
+    uint64_t data[72]{};
+};
+
+inline constexpr auto make_crc64_x2n_table() -> crc64_x2n_table
+{
+    crc64_x2n_table table{};
+    uint64_t p = uint64_t(1) << 62; // x^1
+    table.data[0] = p;
+    for(size_t k = 1; k < 72; ++k)
+    {
+        p = crc64_multmod(p, p);
+        table.data[k] = p;
+    }
+    return table;
+}
+
+// x^(8 * bytes) mod P by repeated squaring.
+inline auto crc64_shift_bytes(size_t bytes) -> uint64_t
+{
+    static constexpr crc64_x2n_table table = make_crc64_x2n_table();
+    uint64_t p = uint64_t(1) << 63; // x^0
+    size_t k = 3;
+    for(; bytes; bytes >>= 1, ++k)
+    {
+        if(bytes & 1)
+        {
+            p = crc64_multmod(table.data[k], p);
+        }
+    }
+    return p;
+}
+
+#ifdef HPP_ARCH_X86
+// Folds a 128 bit lane forward by the distance encoded in k and xors it onto next.
+// The low qword of k holds x^(d + 63) mod P, the high qword x^(d - 1) mod P.
+HPP_TARGET("pclmul,sse4.1")
+inline auto crc64_fold(__m128i lane, __m128i k, __m128i next) -> __m128i
+{
+    const auto lo = _mm_clmulepi64_si128(lane, k, 0x00);
+    const auto hi = _mm_clmulepi64_si128(lane, k, 0x11);
+    return _mm_xor_si128(_mm_xor_si128(lo, hi), next);
+}
+
+HPP_TARGET("pclmul,sse4.1")
+inline auto hash_impl_clmul(const char* data, size_t size, uint64_t crc) -> uint64_t
+{
+    if(size < 64)
+    {
+        return hash_impl_slice8(data, size, crc);
+    }
+
+    constexpr uint64_t k128_lo = crc64_xpow_mod(128 + 63);
+    constexpr uint64_t k128_hi = crc64_xpow_mod(128 - 1);
+    constexpr uint64_t k512_lo = crc64_xpow_mod(512 + 63);
+    constexpr uint64_t k512_hi = crc64_xpow_mod(512 - 1);
+
+    const auto k128 = _mm_set_epi64x(static_cast<long long>(k128_hi), static_cast<long long>(k128_lo));
+    const auto k512 = _mm_set_epi64x(static_cast<long long>(k512_hi), static_cast<long long>(k512_lo));
+
+    auto load = [](const char* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); };
+
+    auto x0 = _mm_xor_si128(load(data), _mm_set_epi64x(0, static_cast<long long>(crc)));
+    auto x1 = load(data + 16);
+    auto x2 = load(data + 32);
+    auto x3 = load(data + 48);
+    data += 64;
+    size -= 64;
+
+    for(; size >= 64; size -= 64, data += 64)
+    {
+        x0 = crc64_fold(x0, k512, load(data));
+        x1 = crc64_fold(x1, k512, load(data + 16));
+        x2 = crc64_fold(x2, k512, load(data + 32));
+        x3 = crc64_fold(x3, k512, load(data + 48));
+    }
+
+    auto x = crc64_fold(x0, k128, x1);
+    x = crc64_fold(x, k128, x2);
+    x = crc64_fold(x, k128, x3);
+
+    for(; size >= 16; size -= 16, data += 16)
+    {
+        x = crc64_fold(x, k128, load(data));
+    }
+
+    // The folded lane is congruent to everything consumed so far, so its crc
+    // (with a zero seed) is the crc of the whole prefix.
+    alignas(16) char folded[16];
+    _mm_store_si128(reinterpret_cast<__m128i*>(folded), x);
+    crc = hash_impl_slice8(folded, sizeof(folded), 0);
+
+    return hash_impl_slice8(data, size, crc);
+}
+#endif
+
+} // namespace detail
+
+// Runtime counterpart of hash_impl. Produces identical results but uses
+// carry-less multiplication folding when the cpu supports it and
+// slicing-by-8 tables otherwise. Not usable in constant expressions.
+inline auto hash_impl_fast(const char* data, size_t size, uint64_t crc) -> uint64_t
+{
+#ifdef HPP_ARCH_X86
+    const auto& features = detail::get_cpu_features();
+    if(features.pclmul && features.sse41)
+    {
+        return detail::hash_impl_clmul(data, size, crc);
+    }
+#endif
+    return detail::hash_impl_slice8(data, size, crc);
+}
+
+inline auto crc64_fast(const char* data, size_t size) -> uint64_t
+{
+    return hash_impl_fast(data, size, 0);
+}
+
+// Crc of the concatenation a|b given crc(a), crc(b) and the length of b.
+// O(log(len_b)) and independent of the data, so chunks can be hashed
+// separately (e.g. on different threads) and merged afterwards.
+inline auto crc64_combine(uint64_t crc_a, uint64_t crc_b, size_t len_b) -> uint64_t
+{
+    return detail::crc64_multmod(detail::crc64_shift_bytes(len_b), crc_a) ^ crc_b;
+}
+
+// Incremental crc64. Feeding data in any number of chunks gives the same
+// result as crc64 over the concatenated input.
+class crc64_hasher
+{
+public:
+    crc64_hasher() = default;
+
+    auto update(const void* data, size_t size) -> crc64_hasher&
+    {
+        crc_ = hash_impl_fast(static_cast<const char*>(data), size, crc_);
+        size_ += size;
+        return *this;
+    }
+
+    auto update(span<const char> data) -> crc64_hasher&
+    {
+        return update(data.data(), data.size());
+    }
+
+    auto update(span<const uint8_t> data) -> crc64_hasher&
+    {
+        return update(data.data(), data.size());
+    }
+
+    // Appends the input hashed by next as if it was fed to this hasher.
+    auto append(const crc64_hasher& next) -> crc64_hasher&
+    {
+        crc_ = combine(crc_, next.crc_, next.size_);
+        size_ += next.size_;
+        return *this;
+    }
+
+    static auto combine(uint64_t crc_a, uint64_t crc_b, size_t len_b) -> uint64_t
+    {
+        return crc64_combine(crc_a, crc_b, len_b);
+    }
+
+    auto finalize() const -> uint64_t
+    {
+        return crc_;
+    }
+
+    auto size() const -> size_t
+    {
+        return size_;
+    }
+
+    void reset()
+    {
+        crc_ = 0;
+        size_ = 0;
+    }
+
+private:
+    uint64_t crc_{};
+    size_t size_{};
+};
+
 } // namespace hpp
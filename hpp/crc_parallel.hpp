@@ -0,0 +1,172 @@
+#pragma once
+
+#include "crc.hpp"
+#include "finally.hpp"
+#include "optional.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace hpp
+{
+
+namespace detail
+{
+
+// Below this many bytes per worker the thread startup costs more than it saves.
+constexpr size_t crc64_min_parallel_block = size_t(1) << 20;
+
+inline auto crc64_worker_count(size_t size, size_t thread_count) -> size_t
+{
+    if(thread_count == 0)
+    {
+        thread_count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+    const auto max_workers = std::max<size_t>(size / crc64_min_parallel_block, 1);
+    return std::min(thread_count, max_workers);
+}
+
+// Splits [0, size) into count contiguous blocks, hashes each with hash_block(offset, length)
+// (the calling thread takes the first block) and combines the results in order.
+template<typename HashBlock>
+auto crc64_parallel_blocks(size_t size, size_t count, HashBlock&& hash_block) -> uint64_t
+{
+    const auto block_size = size / count;
+
+    std::vector<uint64_t> crcs(count);
+    std::vector<std::exception_ptr> errors(count);
+    std::vector<std::thread> workers;
+    workers.reserve(count - 1);
+    {
+        // Joined even if starting a worker or hashing the first block throws,
+        // a joinable std::thread must not be destroyed.
+        auto join_workers = finally(
+            [&workers]()
+            {
+                for(auto& worker : workers)
+                {
+                    worker.join();
+                }
+            });
+
+        for(size_t i = 1; i < count; ++i)
+        {
+            const auto offset = i * block_size;
+            const auto length = i + 1 == count ? size - offset : block_size;
+            workers.emplace_back(
+                [&hash_block, &crcs, &errors, i, offset, length]()
+                {
+                    try
+                    {
+                        crcs[i] = hash_block(offset, length);
+                    }
+                    catch(...)
+                    {
+                        errors[i] = std::current_exception();
+                    }
+                });
+        }
+        crcs[0] = hash_block(size_t(0), block_size);
+    }
+
+    for(const auto& error : errors)
+    {
+        if(error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    auto crc = crcs[0];
+    for(size_t i = 1; i < count; ++i)
+    {
+        const auto length = i + 1 == count ? size - i * block_size : block_size;
+        crc = crc64_combine(crc, crcs[i], length);
+    }
+    return crc;
+}
+
+} // namespace detail
+
+// Same result as crc64(data, size). The input is split into thread_count
+// blocks which are hashed concurrently and merged with crc64_combine.
+// thread_count == 0 uses std::thread::hardware_concurrency().
+inline auto crc64_parallel(const char* data, size_t size, size_t thread_count = 0) -> uint64_t
+{
+    const auto count = detail::crc64_worker_count(size, thread_count);
+    if(count <= 1)
+    {
+        return crc64_fast(data, size);
+    }
+
+    return detail::crc64_parallel_blocks(size,
+                                         count,
+                                         [data](size_t offset, size_t length)
+                                         {
+                                             return crc64_fast(data + offset, length);
+                                         });
+}
+
+// crc64 of a file's contents. Every worker opens its own stream and reads
+// its block in fixed size chunks, so the file is never loaded whole.
+// Returns nullopt if the file cannot be opened or read.
+inline auto crc64_parallel_file(const std::string& path, size_t thread_count = 0) -> optional<uint64_t>
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if(!file)
+    {
+        return nullopt;
+    }
+    const auto end = file.tellg();
+    if(end < 0)
+    {
+        return nullopt;
+    }
+    file.close();
+
+    const auto size = static_cast<size_t>(end);
+    const auto count = detail::crc64_worker_count(size, thread_count);
+
+    std::atomic<bool> failed{false};
+    auto hash_block = [&path, &failed](size_t offset, size_t length) -> uint64_t
+    {
+        constexpr size_t chunk_size = size_t(1) << 20;
+
+        std::ifstream stream(path, std::ios::binary);
+        if(!stream || !stream.seekg(static_cast<std::streamoff>(offset)))
+        {
+            failed = true;
+            return 0;
+        }
+
+        std::vector<char> chunk(std::min(chunk_size, length));
+        crc64_hasher hasher;
+        while(length > 0)
+        {
+            const auto to_read = std::min(chunk.size(), length);
+            if(!stream.read(chunk.data(), static_cast<std::streamsize>(to_read)))
+            {
+                failed = true;
+                return 0;
+            }
+            hasher.update(chunk.data(), to_read);
+            length -= to_read;
+        }
+        return hasher.finalize();
+    };
+
+    const auto crc =
+        count <= 1 ? hash_block(0, size) : detail::crc64_parallel_blocks(size, count, hash_block);
+    if(failed)
+    {
+        return nullopt;
+    }
+    return crc;
+}
+
+} // namespace hpp
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+
+// Runtime cpu feature detection used to dispatch to the intrinsic code paths.
+// Define HPP_NO_INTRINSICS to force the portable implementations everywhere.
+#if !defined(HPP_NO_INTRINSICS) &&                                                                       \
+    (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86))
+#define HPP_ARCH_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
+#elif !defined(HPP_NO_INTRINSICS) && defined(__aarch64__) && defined(__linux__)
+#define HPP_ARCH_ARM64_LINUX
+#include <sys/auxv.h>
+#endif
+
+// Allows a single function to be compiled for an instruction set that is not
+// enabled for the whole translation unit. MSVC does not need it.
+#if defined(HPP_ARCH_X86) && (defined(__GNUC__) || defined(__clang__))
+#define HPP_TARGET(features) __attribute__((target(features)))
+#else
+#define HPP_TARGET(features)
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define HPP_FORCE_INLINE __forceinline
+#elif defined(__GNUC__) || defined(__clang__)
+#define HPP_FORCE_INLINE inline __attribute__((always_inline))
+#else
+#define HPP_FORCE_INLINE inline
+#endif
+
+namespace hpp
+{
+namespace detail
+{
+
+struct cpu_features
+{
+    bool ssse3{};
+    bool sse41{};
+    bool pclmul{};
+    bool avx2{};
+    bool avx512f{};
+    // x86 SHA extensions or the armv8 sha1 crypto instructions
+    bool sha{};
+};
+
+#ifdef HPP_ARCH_X86
+inline void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t (&regs)[4])
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4]{};
+    __cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for(int i = 0; i < 4; ++i)
+    {
+        regs[i] = static_cast<uint32_t>(info[i]);
+    }
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// Extended control register 0, tells which register states the os saves on context switch.
+inline auto xgetbv0() -> uint64_t
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    return _xgetbv(0);
+#else
+    uint32_t eax{};
+    uint32_t edx{};
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (uint64_t(edx) << 32) | eax;
+#endif
+}
+#endif
+
+inline auto detect_cpu_features() -> cpu_features
+{
+    cpu_features result{};
+#ifdef HPP_ARCH_X86
+    uint32_t regs[4]{};
+    cpuid(0, 0, regs);
+    const auto max_leaf = regs[0];
+    if(max_leaf < 1)
+    {
+        return result;
+    }
+
+    cpuid(1, 0, regs);
+    result.pclmul = (regs[2] & (1u << 1)) != 0;
+    result.ssse3 = (regs[2] & (1u << 9)) != 0;
+    result.sse41 = (regs[2] & (1u << 19)) != 0;
+
+    const bool osxsave = (regs[2] & (1u << 27)) != 0;
+    const bool avx = (regs[2] & (1u << 28)) != 0;
+    if(max_leaf < 7)
+    {
+        return result;
+    }
+
+    const auto xcr0 = osxsave && avx ? xgetbv0() : 0;
+    const bool os_avx = (xcr0 & 0x6) == 0x6;
+    const bool os_avx512 = (xcr0 & 0xe6) == 0xe6;
+
+    cpuid(7, 0, regs);
+    result.avx2 = os_avx && (regs[1] & (1u << 5)) != 0;
+    result.avx512f = os_avx512 && (regs[1] & (1u << 16)) != 0;
+    result.sha = (regs[1] & (1u << 29)) != 0;
+#elif defined(HPP_ARCH_ARM64_LINUX)
+    // HWCAP_SHA1, spelled out since older kernel headers may lack it
+    result.sha = (getauxval(AT_HWCAP) & (1ul << 5)) != 0;
+#endif
+    return result;
+}
+
+inline auto get_cpu_features() -> const cpu_features&
+{
+    static const cpu_features features = detect_cpu_features();
+    return features;
+}
+
+} // namespace detail
+} // namespace hpp
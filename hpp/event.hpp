@@ -2,18 +2,46 @@
 #include "delegate.hpp"
 #include "optional.hpp"
 #include "sentinel.hpp"
+#include "slot_map.hpp"
 #include "source_location.hpp"
 #include <algorithm>
 #include <map>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace hpp
 {
-template<typename T>
+/// Slot storage modes of event.
+///
+/// tree_slot_storage keeps the slots in a std::multimap ordered by priority.
+/// It is the default, and the only mode with get_slots().
+///
+/// contiguous_slot_storage keeps the slots in priority order in two parallel
+/// vectors: the delegates and the removed flags, which emit reads, and a
+/// side array with the keys, priorities, sentinels and source locations.
+/// Emitting streams through one array without chasing tree nodes, at the cost
+/// of an O(n) connect for slots that do not go to the back of their priority.
+/// Slots connected while the event is emitting are called from the next emit on.
+///
+/// In both modes a slot_key is the packed value of a generational handle
+/// (hpp::packed_key64) into a slot_map that locates the slot, so disconnecting
+/// by key is O(1) and a stale key is ignored.
+struct tree_slot_storage
+{
+};
+struct contiguous_slot_storage
+{
+};
+
+template<typename T, typename Storage = tree_slot_storage>
 class event;
 
-template<typename... Args>
-class event<void(Args...)>
+template<typename T>
+using contiguous_event = event<T, contiguous_slot_storage>;
+
+template<typename Storage, typename... Args>
+class event<void(Args...), Storage>
 {
 public:
     using slot_type = delegate<void(Args...)>;
@@ -180,7 +208,7 @@ public:
         {
             return;
         }
-        disconnect(get_impl().current_id_);
+        disconnect(get_impl().current_key());
     }
 
     void disconnect(const slot_key& key) noexcept
@@ -223,7 +251,7 @@ public:
 
         if(has_impl() && s.has_impl())
         {
-            return get_impl().slots_ == s.get_impl().slots_;
+            return get_impl().equal_impl(s.get_impl());
         }
 
         return false;
@@ -240,11 +268,12 @@ public:
         {
             return true;
         }
-        return get_impl().slots_.empty();
+        return get_impl().empty_impl();
     }
 
     const slot_container& get_slots() const
     {
+        static_assert(std::is_same<Storage, tree_slot_storage>::value, "get_slots needs tree_slot_storage");
         if(!has_impl())
         {
             static const slot_container empty;
@@ -258,7 +287,7 @@ public:
     {
         if(rhs.has_impl())
         {
-            get_impl() = rhs.get_impl();
+            impl_ = std::make_shared<impl>(rhs.get_impl());
         }
     }
 
@@ -268,9 +297,11 @@ public:
         {
             return *this;
         }
+        // A fresh impl, connections made from the old one must not reach
+        // the slots copied from rhs.
         if(rhs.has_impl())
         {
-            get_impl() = rhs.get_impl();
+            impl_ = std::make_shared<impl>(rhs.get_impl());
         }
         else
         {
@@ -295,7 +326,22 @@ public:
     }
 
 private:
-    struct impl
+    using handle_type = hpp::packed_key64;
+
+    // Live keys have odd generations, so a key with an even one (like 0, or
+    // a forged key) can never match a free or retired slot of the index.
+    template<typename Index>
+    static auto find_handle(Index& index, slot_key key) -> decltype(std::begin(index))
+    {
+        auto handle = handle_type::from_value(key);
+        if((handle.generation() & 1) == 0)
+        {
+            return std::end(index);
+        }
+        return index.find(handle);
+    }
+
+    struct tree_impl
     {
         static bool check_for_remove(slot_t& slot)
         {
@@ -313,40 +359,48 @@ private:
             return false;
         }
 
+        tree_impl() = default;
+        tree_impl(const tree_impl& rhs)
+            : current_id_(rhs.current_id_)
+            , slots_(rhs.slots_)
+            , index_(rhs.index_)
+        {
+            rebind_index();
+        }
+        tree_impl& operator=(const tree_impl& rhs)
+        {
+            if(this != &rhs)
+            {
+                current_id_ = rhs.current_id_;
+                slots_ = rhs.slots_;
+                index_ = rhs.index_;
+                rebind_index();
+            }
+            return *this;
+        }
+
         template<typename... A>
         slot_key connect_impl(const slot_sentinel& sentinel,
                               slot_priority priority,
                               const hpp::source_location& location,
                               A&&... args)
         {
-            auto id = free_id_++;
-
-            slot_t slot{slot_key(id), slot_type(std::forward<A>(args)...), sentinel, location, false};
+            slot_t slot{slot_key{}, slot_type(std::forward<A>(args)...), sentinel, location, false};
 
-            slots_.emplace(priority, std::move(slot));
-            return id;
+            auto it = slots_.emplace(priority, std::move(slot));
+            auto key = index_.insert(it).value();
+            it->second.key = key;
+            return key;
         }
 
         void disconnect_impl(const slot_key& key)
         {
-            for(auto it = std::begin(slots_); it != std::end(slots_); ++it)
+            auto found = find_handle(index_, key);
+            if(found == std::end(index_))
             {
-                auto& element_slot = it->second;
-                if(element_slot.key != key)
-                {
-                    continue;
-                }
-
-                if(depth_ == 0)
-                {
-                    slots_.erase(it);
-                }
-                else
-                {
-                    element_slot.removed = true;
-                }
                 return;
             }
+            remove(*found);
         }
 
         void disconnect_impl(slot_type& slot)
@@ -356,30 +410,68 @@ private:
                 auto& element_slot = it->second;
                 if(element_slot.slot == slot)
                 {
-                    if(depth_ == 0)
-                    {
-                        slots_.erase(it);
-                    }
-                    else
-                    {
-                        element_slot.removed = true;
-                    }
+                    remove(it);
                     return;
                 }
             }
         }
 
+        void remove(typename slot_container::iterator it)
+        {
+            if(depth_ == 0)
+            {
+                index_.erase(handle_type::from_value(it->second.key));
+                slots_.erase(it);
+            }
+            else
+            {
+                it->second.removed = true;
+                collect_garbage_ = true;
+            }
+        }
+
+        // The copied index points into the source's slots.
+        void rebind_index()
+        {
+            for(auto it = std::begin(slots_); it != std::end(slots_); ++it)
+            {
+                index_[handle_type::from_value(it->second.key)] = it;
+            }
+        }
+
+        /// Keeps the emit bookkeeping right if a slot throws.
+        struct emit_scope
+        {
+            emit_scope(const tree_impl& owner)
+                : owner_(owner)
+                , previous_id_(owner.current_id_)
+            {
+                owner_.depth_++;
+            }
+            ~emit_scope()
+            {
+                owner_.current_id_ = previous_id_;
+                // an outer emit may still be iterating over the removed slots
+                if(--owner_.depth_ == 0 && owner_.collect_garbage_)
+                {
+                    owner_.collect_garbage();
+                }
+            }
+
+            const tree_impl& owner_;
+            slot_key previous_id_;
+        };
+
         void emit_impl(Args... args) const
         {
-            bool collect_garbage{};
-            depth_++;
+            emit_scope scope(*this);
             for(auto& slot : slots_)
             {
                 current_id_ = slot.second.key;
 
                 if(check_for_remove(slot.second))
                 {
-                    collect_garbage = true;
+                    collect_garbage_ = true;
                     continue;
                 }
 
@@ -387,36 +479,427 @@ private:
 
                 if(check_for_remove(slot.second))
                 {
-                    collect_garbage = true;
+                    collect_garbage_ = true;
                     continue;
                 }
             }
-            depth_--;
+        }
 
-            if(collect_garbage)
+        void collect_garbage() const noexcept
+        {
+            collect_garbage_ = false;
+            auto it = std::begin(slots_);
+            while(it != std::end(slots_))
             {
-                auto it = std::begin(slots_);
-                while(it != std::end(slots_))
+                if(it->second.removed)
                 {
-                    if(it->second.removed)
-                    {
-                        it = slots_.erase(it);
-                    }
-                    else
-                    {
-                        it++;
-                    }
+                    index_.erase(handle_type::from_value(it->second.key));
+                    it = slots_.erase(it);
+                }
+                else
+                {
+                    it++;
                 }
             }
         }
 
+        slot_key current_key() const
+        {
+            return current_id_;
+        }
+
+        /// Same connected slots with the same priorities, in the same order.
+        bool equal_impl(const tree_impl& rhs) const
+        {
+            auto it = std::begin(slots_);
+            auto rhs_it = std::begin(rhs.slots_);
+            for(;; ++it, ++rhs_it)
+            {
+                while(it != std::end(slots_) && check_for_remove(it->second))
+                {
+                    ++it;
+                }
+                while(rhs_it != std::end(rhs.slots_) && check_for_remove(rhs_it->second))
+                {
+                    ++rhs_it;
+                }
+                if(it == std::end(slots_) || rhs_it == std::end(rhs.slots_))
+                {
+                    return it == std::end(slots_) && rhs_it == std::end(rhs.slots_);
+                }
+                if(it->first != rhs_it->first || !(it->second.slot == rhs_it->second.slot))
+                {
+                    return false;
+                }
+            }
+        }
+
+        /// Slots that are disconnected or whose sentinel expired do not count.
+        bool empty_impl() const
+        {
+            for(auto& slot : slots_)
+            {
+                if(!check_for_remove(slot.second))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
         mutable uint32_t depth_{};
+        mutable bool collect_garbage_{};
         mutable slot_key current_id_{};
-        slot_key free_id_ = 1;
         /// The slots connected to the signal
         mutable slot_container slots_;
+        /// slot_key -> node in slots_
+        mutable hpp::slot_map<typename slot_container::iterator, handle_type> index_;
     };
 
+    struct contiguous_impl
+    {
+        /// What emit touches for every slot.
+        struct hot_slot
+        {
+            slot_type slot{};
+            bool removed{};
+            bool guarded{}; // has a sentinel to check
+        };
+
+        /// Everything else, at the same index as the hot_slot.
+        struct cold_slot
+        {
+            slot_key key{};
+            slot_priority priority{};
+            slot_sentinel sentinel = hpp::nullopt;
+            hpp::source_location location = hpp::source_location::current();
+        };
+
+        /// Keeps the emit bookkeeping right if a slot throws.
+        struct emit_scope
+        {
+            emit_scope(const contiguous_impl& owner)
+                : owner_(owner)
+                , previous_index_(owner.current_index_)
+            {
+                owner_.depth_++;
+            }
+            ~emit_scope()
+            {
+                owner_.current_index_ = previous_index_;
+                if(--owner_.depth_ == 0)
+                {
+                    owner_.collect_garbage();
+                }
+            }
+
+            const contiguous_impl& owner_;
+            size_t previous_index_;
+        };
+
+        static constexpr size_t no_index = size_t(-1);
+        // marks index_ entries that point into pending_
+        static constexpr size_t pending_bit = size_t(1) << (sizeof(size_t) * 8 - 1);
+
+        contiguous_impl() = default;
+        // The copy is not emitting, even if rhs is.
+        contiguous_impl(const contiguous_impl& rhs)
+            : removed_count_(rhs.removed_count_)
+            , hot_(rhs.hot_)
+            , cold_(rhs.cold_)
+            , pending_(rhs.pending_)
+            , index_(rhs.index_)
+        {
+            collect_garbage();
+        }
+        contiguous_impl& operator=(const contiguous_impl&) = delete;
+
+        bool check_for_remove(size_t index) const
+        {
+            auto& hot = hot_[index];
+            if(hot.removed)
+            {
+                return true;
+            }
+
+            if(hot.guarded && cold_[index].sentinel.value().expired())
+            {
+                hot.removed = true;
+                removed_count_++;
+                return true;
+            }
+
+            return false;
+        }
+
+        template<typename... A>
+        slot_key connect_impl(const slot_sentinel& sentinel,
+                              slot_priority priority,
+                              const hpp::source_location& location,
+                              A&&... args)
+        {
+            hot_slot hot{slot_type(std::forward<A>(args)...), false, sentinel != hpp::nullopt};
+            auto key = index_.insert(pending_bit | pending_.size()).value();
+            cold_slot cold{key, priority, sentinel, location};
+
+            if(depth_ == 0)
+            {
+                // slots left pending by a failed collect_garbage() go first
+                if(!pending_.empty())
+                {
+                    collect_garbage();
+                }
+                insert_sorted(std::move(hot), std::move(cold));
+            }
+            else
+            {
+                // emit walks hot_ by index, so it must not move
+                pending_.emplace_back(std::move(hot), std::move(cold));
+            }
+            return key;
+        }
+
+        void disconnect_impl(const slot_key& key)
+        {
+            auto found = find_handle(index_, key);
+            if(found == std::end(index_))
+            {
+                return;
+            }
+            auto position = *found;
+            index_.erase(handle_type::from_value(key));
+            if(position & pending_bit)
+            {
+                pending_[position & ~pending_bit].first.removed = true;
+            }
+            else
+            {
+                remove_at(position);
+            }
+        }
+
+        void disconnect_impl(slot_type& slot)
+        {
+            for(size_t i = 0; i < hot_.size(); ++i)
+            {
+                if(!hot_[i].removed && hot_[i].slot == slot)
+                {
+                    disconnect_impl(cold_[i].key);
+                    return;
+                }
+            }
+            for(auto& pending : pending_)
+            {
+                if(!pending.first.removed && pending.first.slot == slot)
+                {
+                    disconnect_impl(pending.second.key);
+                    return;
+                }
+            }
+        }
+
+        void emit_impl(Args... args) const
+        {
+            emit_scope scope(*this);
+            // connect() defers to pending_ and disconnect() only marks while
+            // emitting, so the size stays the same
+            const auto count = hot_.size();
+            for(size_t i = 0; i < count; ++i)
+            {
+                current_index_ = i;
+
+                if(check_for_remove(i))
+                {
+                    continue;
+                }
+
+                hot_[i].slot(args...);
+
+                check_for_remove(i);
+            }
+        }
+
+        slot_key current_key() const
+        {
+            return current_index_ < cold_.size() ? cold_[current_index_].key : slot_key{};
+        }
+
+        /// Same connected slots with the same priorities, in the same order.
+        /// Slots connected during an emit come last, as they are not merged yet.
+        bool equal_impl(const contiguous_impl& rhs) const
+        {
+            size_t i = 0;
+            size_t rhs_i = 0;
+            for(;; ++i, ++rhs_i)
+            {
+                i = next_live(i);
+                rhs_i = rhs.next_live(rhs_i);
+                const auto end = hot_.size() + pending_.size();
+                const auto rhs_end = rhs.hot_.size() + rhs.pending_.size();
+                if(i == end || rhs_i == rhs_end)
+                {
+                    return i == end && rhs_i == rhs_end;
+                }
+                const auto& lhs_slot = i < hot_.size() ? hot_[i] : pending_[i - hot_.size()].first;
+                const auto& lhs_cold = i < hot_.size() ? cold_[i] : pending_[i - hot_.size()].second;
+                const auto& rhs_slot =
+                    rhs_i < rhs.hot_.size() ? rhs.hot_[rhs_i] : rhs.pending_[rhs_i - rhs.hot_.size()].first;
+                const auto& rhs_cold =
+                    rhs_i < rhs.hot_.size() ? rhs.cold_[rhs_i] : rhs.pending_[rhs_i - rhs.hot_.size()].second;
+                if(lhs_cold.priority != rhs_cold.priority || !(lhs_slot.slot == rhs_slot.slot))
+                {
+                    return false;
+                }
+            }
+        }
+
+        /// Slots that are disconnected or whose sentinel expired do not count.
+        bool empty_impl() const
+        {
+            return next_live(0) == hot_.size() + pending_.size();
+        }
+
+        /// The first slot at or after index that is still connected, counting
+        /// pending_ after hot_. Marks the slots of hot_ whose sentinel expired.
+        size_t next_live(size_t index) const
+        {
+            for(; index < hot_.size(); ++index)
+            {
+                if(!check_for_remove(index))
+                {
+                    return index;
+                }
+            }
+            for(; index < hot_.size() + pending_.size(); ++index)
+            {
+                // an expired one stays indexed until it is merged into hot_
+                const auto& pending = pending_[index - hot_.size()];
+                if(!pending.first.removed &&
+                   !(pending.first.guarded && pending.second.sentinel.value().expired()))
+                {
+                    return index;
+                }
+            }
+            return index;
+        }
+
+        // Only marks the slot. Outside of emit the arrays are compacted once
+        // half of the slots are removed, so this is O(1) amortized.
+        void remove_at(size_t index)
+        {
+            if(hot_[index].removed)
+            {
+                return;
+            }
+            hot_[index].removed = true;
+            removed_count_++;
+            if(depth_ == 0 && removed_count_ * 2 > hot_.size())
+            {
+                compact();
+            }
+        }
+
+        // After the slots of the same priority, like std::multimap::emplace.
+        void insert_sorted(hot_slot&& hot, cold_slot&& cold) const
+        {
+            auto it = std::upper_bound(std::begin(cold_),
+                                       std::end(cold_),
+                                       cold.priority,
+                                       [](slot_priority priority, const cold_slot& element)
+                                       {
+                                           return priority > element.priority;
+                                       });
+            auto index = size_t(std::distance(std::begin(cold_), it));
+            cold_.insert(it, std::move(cold));
+            hot_.insert(std::begin(hot_) + std::ptrdiff_t(index), std::move(hot));
+            for(; index < cold_.size(); ++index)
+            {
+                // a removed slot's key may be disconnected already and its
+                // handle reused, so this lookup must be checked
+                auto found = index_.find(handle_type::from_value(cold_[index].key));
+                if(found != std::end(index_))
+                {
+                    *found = index;
+                }
+            }
+        }
+
+        void compact() const
+        {
+            size_t kept = 0;
+            for(size_t i = 0; i < hot_.size(); ++i)
+            {
+                if(hot_[i].removed)
+                {
+                    // still indexed if its sentinel expired
+                    index_.erase(handle_type::from_value(cold_[i].key));
+                    continue;
+                }
+                if(kept != i)
+                {
+                    hot_[kept] = std::move(hot_[i]);
+                    cold_[kept] = std::move(cold_[i]);
+                    index_[handle_type::from_value(cold_[kept].key)] = kept;
+                }
+                kept++;
+            }
+            hot_.resize(kept);
+            cold_.resize(kept);
+            removed_count_ = 0;
+        }
+
+        // Called when the outermost emit returns, from a destructor, so it
+        // must not throw. Compacting works in place and the pending slots
+        // are only merged once the arrays have room for all of them. If that
+        // reserve fails they stay pending, still connected and indexed, and
+        // are merged by the next connect() or emit.
+        void collect_garbage() const noexcept
+        {
+            if(removed_count_ != 0)
+            {
+                compact();
+            }
+            if(pending_.empty())
+            {
+                return;
+            }
+
+            try
+            {
+                hot_.reserve(hot_.size() + pending_.size());
+                cold_.reserve(cold_.size() + pending_.size());
+            }
+            catch(...)
+            {
+                return;
+            }
+
+            for(auto& pending : pending_)
+            {
+                if(!pending.first.removed)
+                {
+                    insert_sorted(std::move(pending.first), std::move(pending.second));
+                }
+            }
+            pending_.clear();
+        }
+
+        mutable uint32_t depth_{};
+        mutable size_t current_index_ = no_index;
+        mutable size_t removed_count_{};
+        /// The slots connected to the signal, sorted by descending priority
+        mutable std::vector<hot_slot> hot_;
+        mutable std::vector<cold_slot> cold_;
+        /// Slots connected during an emit
+        mutable std::vector<std::pair<hot_slot, cold_slot>> pending_;
+        /// slot_key -> index in hot_ and cold_, or in pending_ with pending_bit
+        mutable hpp::slot_map<size_t, handle_type> index_;
+    };
+
+    using impl = typename std::conditional<std::is_same<Storage, contiguous_slot_storage>::value,
+                                           contiguous_impl,
+                                           tree_impl>::type;
+
     bool has_impl() const noexcept
     {
         return !!impl_;
@@ -431,13 +914,93 @@ private:
     {
         if(!impl_)
         {
-            impl_ = std::make_unique<impl>();
+            impl_ = std::make_shared<impl>();
         }
 
         return *impl_;
     }
 
-    std::unique_ptr<impl> impl_;
+    std::shared_ptr<impl> impl_;
+
+public:
+    /// Disconnects its slot when destroyed or reassigned, without a search.
+    /// It does not keep the event alive and does nothing once the event is
+    /// destroyed. Moving the event keeps the connection working.
+    class connection
+    {
+    public:
+        connection() = default;
+        connection(connection&& rhs) noexcept
+            : owner_(std::move(rhs.owner_))
+            , key_(rhs.key_)
+        {
+            rhs.key_ = {};
+        }
+        connection& operator=(connection&& rhs) noexcept
+        {
+            if(this != &rhs)
+            {
+                disconnect();
+                owner_ = std::move(rhs.owner_);
+                key_ = rhs.key_;
+                rhs.key_ = {};
+            }
+            return *this;
+        }
+        ~connection()
+        {
+            disconnect();
+        }
+
+        void disconnect() noexcept
+        {
+            if(auto owner = owner_.lock())
+            {
+                owner->disconnect_impl(key_);
+            }
+            release();
+        }
+
+        /// Stops tracking the slot without disconnecting it.
+        slot_key release() noexcept
+        {
+            owner_.reset();
+            auto key = key_;
+            key_ = {};
+            return key;
+        }
+
+        slot_key key() const noexcept
+        {
+            return key_;
+        }
+
+        bool connected() const noexcept
+        {
+            auto owner = owner_.lock();
+            return owner && find_handle(owner->index_, key_) != std::end(owner->index_);
+        }
+
+    private:
+        friend class event;
+
+        connection(const std::shared_ptr<impl>& owner, slot_key key)
+            : owner_(owner)
+            , key_(key)
+        {
+        }
+
+        std::weak_ptr<impl> owner_;
+        slot_key key_{};
+    };
+
+    /// Wraps the key returned by connect() in a scoped connection.
+    ///     auto connection = e.make_connection(e.connect(this, &listener::on_change));
+    connection make_connection(slot_key key)
+    {
+        get_impl();
+        return connection(impl_, key);
+    }
 };
 
 template <typename T>
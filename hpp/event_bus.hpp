@@ -0,0 +1,566 @@
+#pragma once
+#include "concurrent_event.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace hpp
+{
+template<typename T>
+class event_bus;
+
+/// Fans events out from any number of producer threads to slots bound to
+/// consumer threads.
+///
+/// connect() binds a slot to a target thread. Every target has a mailbox: a
+/// bounded, lock-free multi producer single consumer ring of argument tuples,
+/// and a concurrent_event with the slots bound to it. emit() copies the
+/// arguments into the mailbox of every target and returns without calling
+/// anything. Each target thread calls dispatch() (once per frame, after a
+/// wait, ...) which calls its slots for every tuple queued since, in the
+/// order the producers queued them.
+///
+/// Emitting takes no lock. Connecting and disconnecting may happen from any
+/// thread, also from a slot. A mailbox is created by the first connect() to
+/// its target and stays until close(target), so tuples keep going to a
+/// target whose slots were all disconnected; dispatch() then just drops
+/// them. A consumer thread should close() its mailbox before it exits.
+/// Like the slot lists of concurrent_event, a closed mailbox is freed once
+/// every emit, dispatch or disconnect that could still be walking through
+/// it returned.
+///
+/// When a mailbox is full the new tuple is dropped for that target and
+/// counted by dropped(). Unlike queued_event, which overwrites its oldest
+/// tuple, the queued ones are kept: a producer can not take a tuple back
+/// from the consumer without a lock. Size the mailboxes for the burst a
+/// consumer may fall behind.
+template<typename... Args>
+class event_bus<void(Args...)>
+{
+    using event_type = concurrent_event<void(Args...)>;
+
+public:
+    using value_type = std::tuple<typename std::decay<Args>::type...>;
+    using executor_id = std::thread::id;
+    using slot_key = uint64_t;
+    using slot_sentinel = typename event_type::slot_sentinel;
+    using slot_priority = typename event_type::slot_priority;
+
+    /// mailbox_capacity is rounded up to a power of two, at least 2.
+    explicit event_bus(size_t mailbox_capacity = 1024)
+        : mailbox_capacity_(round_up_pow2(mailbox_capacity))
+    {
+    }
+
+    event_bus(const event_bus&) = delete;
+    event_bus& operator=(const event_bus&) = delete;
+
+    /// No producer or consumer may be running.
+    ~event_bus()
+    {
+        auto box = mailboxes_.load(std::memory_order_relaxed);
+        while(box != nullptr)
+        {
+            auto next = box->next.load(std::memory_order_relaxed);
+            delete box;
+            box = next;
+        }
+    }
+
+    template<class C>
+    slot_key connect(executor_id target,
+                     C* const object_ptr,
+                     void (C::*const method_ptr)(Args...),
+                     const hpp::source_location& location = hpp::source_location::current())
+    {
+        read_scope scope(*this);
+        auto& box = get_or_create(target);
+        return make_key(box, box.slots.connect(object_ptr, method_ptr, location));
+    }
+
+    template<class C>
+    slot_key connect(executor_id target,
+                     C* const object_ptr,
+                     void (C::*const method_ptr)(Args...) const,
+                     const hpp::source_location& location = hpp::source_location::current())
+    {
+        read_scope scope(*this);
+        auto& box = get_or_create(target);
+        return make_key(box, box.slots.connect(object_ptr, method_ptr, location));
+    }
+
+    template<typename T>
+    slot_key connect(executor_id target,
+                     T&& f,
+                     const hpp::source_location& location = hpp::source_location::current())
+    {
+        read_scope scope(*this);
+        auto& box = get_or_create(target);
+        return make_key(box, box.slots.connect(std::forward<T>(f), location));
+    }
+
+    template<typename T>
+    slot_key connect(executor_id target,
+                     slot_priority priority,
+                     T&& f,
+                     const hpp::source_location& location = hpp::source_location::current())
+    {
+        read_scope scope(*this);
+        auto& box = get_or_create(target);
+        return make_key(box, box.slots.connect(priority, std::forward<T>(f), location));
+    }
+
+    template<typename T>
+    slot_key connect(executor_id target,
+                     const slot_sentinel& sentinel,
+                     T&& f,
+                     const hpp::source_location& location = hpp::source_location::current())
+    {
+        read_scope scope(*this);
+        auto& box = get_or_create(target);
+        return make_key(box, box.slots.connect(sentinel, std::forward<T>(f), location));
+    }
+
+    void disconnect(const slot_key& key)
+    {
+        const auto index = key >> index_shift;
+        read_scope scope(*this);
+        for(auto box = mailboxes_.load(std::memory_order_acquire); box != nullptr;
+            box = box->next.load(std::memory_order_acquire))
+        {
+            if(box->index == index)
+            {
+                box->slots.disconnect(key & inner_key_mask);
+                return;
+            }
+        }
+    }
+
+    /// Stops delivering to target: takes its mailbox out of the fan-out,
+    /// drops the tuples queued in it and disconnects its slots. Call it from
+    /// target before the thread exits, or from another thread once target no
+    /// longer dispatches. A later connect() to the same id, as from a new
+    /// thread that got the id of an exited one, starts a new mailbox.
+    /// Returns false if target has no mailbox.
+    bool close(executor_id target = std::this_thread::get_id())
+    {
+        std::lock_guard<std::mutex> lock(create_mutex_);
+        mailbox* previous{};
+        auto box = mailboxes_.load(std::memory_order_relaxed);
+        for(; box != nullptr && box->id != target; box = box->next.load(std::memory_order_relaxed))
+        {
+            previous = box;
+        }
+        if(box == nullptr)
+        {
+            return false;
+        }
+
+        // Producers and disconnect() may still be walking through the
+        // mailbox, so it is only unlinked here and freed by a later
+        // collect_closed(). Its next pointer stays valid and leads them back
+        // to the list.
+        auto next = box->next.load(std::memory_order_relaxed);
+        if(previous == nullptr)
+        {
+            mailboxes_.store(next, std::memory_order_release);
+        }
+        else
+        {
+            previous->next.store(next, std::memory_order_release);
+        }
+
+        box->queue.close();
+        box->slots.disconnect_all();
+        collect_closed(box);
+        return true;
+    }
+
+    /// Queues a copy of the arguments for every target. Lock-free, callable
+    /// from any thread.
+    void emit(Args... args)
+    {
+        read_scope scope(*this);
+        for(auto box = mailboxes_.load(std::memory_order_acquire); box != nullptr;
+            box = box->next.load(std::memory_order_acquire))
+        {
+            // a mailbox closed meanwhile refuses the tuple, that is no drop
+            if(!box->queue.try_push(args...) && !box->queue.closed())
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void operator()(Args... args)
+    {
+        emit(args...);
+    }
+
+    /// Calls the slots bound to target for the tuples queued in its mailbox,
+    /// at most max_events of them. Returns the number of tuples taken.
+    /// Only one thread at a time may dispatch a target, normally the target
+    /// itself. Tuples queued while dispatching are taken by this call too,
+    /// up to max_events.
+    size_t dispatch(executor_id target = std::this_thread::get_id(), size_t max_events = size_t(-1))
+    {
+        size_t count{};
+        {
+            // also keeps the mailbox alive if a slot closes it
+            read_scope scope(*this);
+            auto box = find(target);
+            if(box == nullptr)
+            {
+                return 0;
+            }
+
+            for(; count < max_events; ++count)
+            {
+                // taken out before the call, so a slot may dispatch again
+                hpp::optional<value_type> value;
+                if(!box->queue.try_pop(value))
+                {
+                    break;
+                }
+                emit_tuple(box->slots, *value, std::index_sequence_for<Args...>{});
+            }
+        }
+
+        // Consumers dispatch regularly, so they free the closed mailboxes
+        // without waiting for the next close(). Never blocks.
+        if(closed_count_.load(std::memory_order_relaxed) != 0)
+        {
+            std::unique_lock<std::mutex> lock(create_mutex_, std::try_to_lock);
+            if(lock.owns_lock())
+            {
+                collect_closed(nullptr);
+            }
+        }
+        return count;
+    }
+
+    /// Tuples waiting in the mailbox of target. Approximate while producers
+    /// or the consumer are running.
+    size_t queued(executor_id target) const
+    {
+        read_scope scope(*this);
+        auto box = find(target);
+        return box == nullptr ? 0 : box->queue.size();
+    }
+
+    size_t mailbox_capacity() const
+    {
+        return mailbox_capacity_;
+    }
+
+    /// Tuples dropped because a mailbox was full, since construction.
+    uint64_t dropped() const
+    {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+private:
+    /// Bounded MPSC ring after Dmitry Vyukov's bounded MPMC queue. Each cell
+    /// carries a sequence number telling whether it is free for the producer
+    /// of a given lap or filled for the consumer, so producers only contend
+    /// on tail_ and the consumer never writes a shared counter with a CAS.
+    class mpsc_ring
+    {
+    public:
+        explicit mpsc_ring(size_t capacity)
+            : cells_(new cell[capacity])
+            , mask_(capacity - 1)
+        {
+            for(size_t i = 0; i < capacity; ++i)
+            {
+                cells_[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        ~mpsc_ring()
+        {
+            hpp::optional<value_type> value;
+            while(try_pop(value))
+            {
+            }
+        }
+
+        template<typename... Ts>
+        bool try_push(Ts&&... args)
+        {
+            auto pos = tail_.load(std::memory_order_relaxed);
+            cell* c;
+            for(;;)
+            {
+                if(pos & closed_bit)
+                {
+                    return false;
+                }
+                c = &cells_[pos & mask_];
+                const auto sequence = c->sequence.load(std::memory_order_acquire);
+                const auto diff = intptr_t(sequence) - intptr_t(pos);
+                if(diff == 0)
+                {
+                    if(tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        break;
+                    }
+                }
+                else if(diff < 0)
+                {
+                    // the consumer has not freed this cell yet, the ring is full
+                    return false;
+                }
+                else
+                {
+                    pos = tail_.load(std::memory_order_relaxed);
+                }
+            }
+
+            ::new(c->storage()) value_type(std::forward<Ts>(args)...);
+            c->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// Single consumer.
+        bool try_pop(hpp::optional<value_type>& value)
+        {
+            const auto pos = head_.load(std::memory_order_relaxed);
+            auto& c = cells_[pos & mask_];
+            if(c.sequence.load(std::memory_order_acquire) != pos + 1)
+            {
+                return false;
+            }
+
+            auto stored = static_cast<value_type*>(c.storage());
+            value.emplace(std::move(*stored));
+            stored->~value_type();
+            head_.store(pos + 1, std::memory_order_relaxed);
+            c.sequence.store(pos + mask_ + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// Makes every later try_push() fail, then drops the queued tuples,
+        /// waiting for the producers still writing theirs. Single consumer.
+        void close()
+        {
+            const auto tail = tail_.fetch_or(closed_bit, std::memory_order_acq_rel) & ~closed_bit;
+            hpp::optional<value_type> value;
+            while(head_.load(std::memory_order_relaxed) != tail)
+            {
+                if(!try_pop(value))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        bool closed() const
+        {
+            return (tail_.load(std::memory_order_relaxed) & closed_bit) != 0;
+        }
+
+        size_t size() const
+        {
+            const auto tail = tail_.load(std::memory_order_relaxed) & ~closed_bit;
+            const auto head = head_.load(std::memory_order_relaxed);
+            return tail > head ? tail - head : 0;
+        }
+
+    private:
+        // Set in tail_ by close(). It changes tail_, so the compare exchange
+        // of a producer that read it before fails and sees the bit.
+        static constexpr size_t closed_bit = size_t(1) << (sizeof(size_t) * 8 - 1);
+
+        struct cell
+        {
+            void* storage()
+            {
+                return data;
+            }
+
+            std::atomic<size_t> sequence{};
+            alignas(value_type) unsigned char data[sizeof(value_type)];
+        };
+
+        // padded apart so producers and the consumer do not share a cache line
+        std::unique_ptr<cell[]> cells_;
+        size_t mask_{};
+        char pad0_[64]{};
+        std::atomic<size_t> tail_{0};
+        char pad1_[64]{};
+        std::atomic<size_t> head_{0};
+    };
+
+    struct mailbox
+    {
+        mailbox(executor_id target, uint64_t key_index, size_t capacity)
+            : id(target)
+            , index(key_index)
+            , queue(capacity)
+        {
+        }
+
+        const executor_id id;
+        const uint64_t index;
+        std::atomic<mailbox*> next{};
+        event_type slots;
+        mpsc_ring queue;
+    };
+
+    // The upper bits of a slot_key hold the mailbox index, the lower ones the
+    // key of the slot in the concurrent_event of the mailbox.
+    static constexpr uint64_t index_shift = 48;
+    static constexpr uint64_t inner_key_mask = (uint64_t(1) << index_shift) - 1;
+    static constexpr uint64_t index_mask = (uint64_t(1) << (64 - index_shift)) - 1;
+
+    // A ring of one cell would take a filled cell for a free one of the next
+    // lap, the sequence numbers need at least two.
+    static size_t round_up_pow2(size_t value)
+    {
+        size_t result = 2;
+        while(result < value)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    static slot_key make_key(const mailbox& box, typename event_type::slot_key key)
+    {
+        return (box.index << index_shift) | (key & inner_key_mask);
+    }
+
+    template<size_t... I>
+    static void emit_tuple(const event_type& slots, value_type& value, std::index_sequence<I...>)
+    {
+        slots.emit(std::get<I>(value)...);
+    }
+
+    /// Registers a walk over the mailbox list as a reader of the current
+    /// epoch. Mailboxes closed during an epoch are freed once the epoch has
+    /// no readers left, see collect_closed().
+    struct read_scope
+    {
+        read_scope(const event_bus& owner)
+            : owner_(owner)
+        {
+            for(;;)
+            {
+                epoch_ = owner_.epoch_.load(std::memory_order_seq_cst);
+                owner_.readers_[epoch_ & 1].fetch_add(1, std::memory_order_seq_cst);
+                if(owner_.epoch_.load(std::memory_order_seq_cst) == epoch_)
+                {
+                    break;
+                }
+                owner_.readers_[epoch_ & 1].fetch_sub(1, std::memory_order_seq_cst);
+            }
+        }
+        ~read_scope()
+        {
+            owner_.readers_[epoch_ & 1].fetch_sub(1, std::memory_order_seq_cst);
+        }
+        read_scope(const read_scope&) = delete;
+        read_scope& operator=(const read_scope&) = delete;
+
+        const event_bus& owner_;
+        uint32_t epoch_{};
+    };
+
+    /// Needs a read_scope or create_mutex_.
+    mailbox* find(executor_id target) const
+    {
+        for(auto box = mailboxes_.load(std::memory_order_acquire); box != nullptr;
+            box = box->next.load(std::memory_order_acquire))
+        {
+            if(box->id == target)
+            {
+                return box;
+            }
+        }
+        return nullptr;
+    }
+
+    /// The caller needs a read_scope to use the mailbox after the lock.
+    mailbox& get_or_create(executor_id target)
+    {
+        std::lock_guard<std::mutex> lock(create_mutex_);
+        if(auto box = find(target))
+        {
+            return *box;
+        }
+
+        // Pushed to the front and only unlinked by close(), so producers and
+        // consumers walk it without a lock.
+        auto head = mailboxes_.load(std::memory_order_relaxed);
+        auto box = new mailbox(target, next_index(), mailbox_capacity_);
+        box->next.store(head, std::memory_order_relaxed);
+        mailboxes_.store(box, std::memory_order_release);
+        collect_closed(nullptr);
+        return *box;
+    }
+
+    // Called with create_mutex_ held. Retires closed (if any) in the current
+    // epoch. Walks that started before the last epoch change may still be in
+    // the mailboxes closed before it. Once they are done those mailboxes can
+    // go and the epoch can advance.
+    void collect_closed(mailbox* closed)
+    {
+        const auto epoch = epoch_.load(std::memory_order_relaxed);
+        if(closed != nullptr)
+        {
+            closed_[epoch & 1].emplace_back(closed);
+            closed_count_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        auto& previous = closed_[(epoch + 1) & 1];
+        if(readers_[(epoch + 1) & 1].load(std::memory_order_seq_cst) == 0)
+        {
+            closed_count_.fetch_sub(previous.size(), std::memory_order_relaxed);
+            previous.clear();
+            epoch_.store(epoch + 1, std::memory_order_seq_cst);
+        }
+    }
+
+    // The key index of a new mailbox. It wraps around in the bits a slot_key
+    // has for it, skipping the indices of open mailboxes.
+    uint64_t next_index()
+    {
+        for(;;)
+        {
+            const auto index = next_index_;
+            next_index_ = (next_index_ + 1) & index_mask;
+
+            auto box = mailboxes_.load(std::memory_order_relaxed);
+            while(box != nullptr && box->index != index)
+            {
+                box = box->next.load(std::memory_order_relaxed);
+            }
+            if(box == nullptr)
+            {
+                return index;
+            }
+        }
+    }
+
+    const size_t mailbox_capacity_;
+    std::atomic<mailbox*> mailboxes_{nullptr};
+    std::atomic<uint64_t> dropped_{0};
+    mutable std::atomic<uint32_t> epoch_{0};
+    mutable std::atomic<size_t> readers_[2]{};
+    /// Guards creating, closing and freeing mailboxes.
+    std::mutex create_mutex_;
+    uint64_t next_index_{};
+    /// Closed mailboxes by the parity of the epoch they were closed in
+    std::vector<std::unique_ptr<mailbox>> closed_[2];
+    std::atomic<size_t> closed_count_{0};
+};
+
+} // end of namespace hpp
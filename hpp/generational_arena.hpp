@@ -0,0 +1,265 @@
+#pragma once
+
+#include "slot_map.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace hpp
+{
+
+// Fixed size memory blocks addressed by slot_map style (index, generation)
+// handles.
+//
+// Blocks live in pages that are never moved or freed before the arena, so a
+// pointer to a block stays valid while its handle does. A free block holds
+// the index of the next free block in its own first bytes (an intrusive free
+// list), so allocate() and deallocate() are O(1) with no extra storage.
+//
+// The generation of every block is kept outside the block memory, using the
+// same key helpers as slot_map (slot_map_key_traits), so a stale or forged
+// handle is detected by get() instead of aliasing a newer allocation:
+// the generation is odd while the block is allocated and even while free,
+// and a block whose generation wraps is retired like an exhausted slot_map
+// slot.
+//
+// create<T>() constructs objects of any type that fits a block; the arena
+// remembers how to destroy them, so objects still alive are destroyed with
+// the arena.
+//
+template <class Key = std::pair<unsigned, unsigned>>
+class generational_arena
+{
+    using key_traits = slot_map_key_traits<Key>;
+
+public:
+    using key_type = Key;
+    using size_type = size_t;
+    using key_size_type = decltype(key_traits::get_index(std::declval<Key>()));
+    using key_generation_type = decltype(key_traits::get_generation(std::declval<Key>()));
+
+    explicit generational_arena(size_type block_size, size_type block_alignment = alignof(std::max_align_t),
+                                size_type blocks_per_page = 256)
+        : block_alignment_((std::max)(block_alignment, alignof(size_type)))
+        , block_size_(round_up((std::max)(block_size, sizeof(size_type)), block_alignment_))
+        , blocks_per_page_((std::max)(blocks_per_page, size_type(1)))
+    {
+        if((block_alignment_ & (block_alignment_ - 1)) != 0)
+        {
+            SLOT_MAP_THROW_EXCEPTION(std::invalid_argument, "block_alignment must be a power of two");
+        }
+    }
+
+    generational_arena(const generational_arena&) = delete;
+    generational_arena& operator=(const generational_arena&) = delete;
+
+    ~generational_arena()
+    {
+        for(size_type index = 0; index < blocks_.size(); ++index)
+        {
+            const auto& block = blocks_[index];
+            if(is_live(block.key) && block.destroy != nullptr)
+            {
+                block.destroy(address(index));
+            }
+        }
+    }
+
+    // Usable bytes per block, block_size rounded up to the alignment.
+    size_type block_size() const
+    {
+        return block_size_;
+    }
+    size_type block_alignment() const
+    {
+        return block_alignment_;
+    }
+    // Number of allocated blocks.
+    size_type size() const
+    {
+        return size_;
+    }
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+    // Number of blocks in the allocated pages.
+    size_type capacity() const
+    {
+        return pages_.size() * blocks_per_page_;
+    }
+
+    // Returns the handle of an uninitialized block. O(1).
+    key_type allocate()
+    {
+        return allocate_block();
+    }
+
+    // Constructs a T in a new block. T must fit the block size and alignment.
+    template <class T, class... Args>
+    key_type create(Args&&... args)
+    {
+        if(sizeof(T) > block_size_ || alignof(T) > block_alignment_)
+        {
+            SLOT_MAP_THROW_EXCEPTION(std::length_error, "type does not fit the arena blocks");
+        }
+        auto key = allocate_block();
+        auto index = size_type(key_traits::get_index(key));
+        try
+        {
+            ::new(address(index)) T(std::forward<Args>(args)...);
+        }
+        catch(...)
+        {
+            deallocate(key);
+            throw;
+        }
+        blocks_[index].destroy = [](void* object)
+        {
+            static_cast<T*>(object)->~T();
+        };
+        return key;
+    }
+
+    // The block of a valid handle, nullptr for a stale or unknown one. O(1).
+    void* get(const key_type& key) const
+    {
+        auto index = size_type(key_traits::get_index(key));
+        if(index >= blocks_.size())
+        {
+            return nullptr;
+        }
+        const auto& block = blocks_[index];
+        if(!is_live(key) || key_traits::get_generation(block.key) != key_traits::get_generation(key))
+        {
+            return nullptr;
+        }
+        return address(index);
+    }
+    template <class T>
+    T* get_as(const key_type& key) const
+    {
+        return static_cast<T*>(get(key));
+    }
+    bool contains(const key_type& key) const
+    {
+        return get(key) != nullptr;
+    }
+
+    // Destroys the object made by create(), if any, and frees the block.
+    // Returns false for a stale or unknown handle. O(1).
+    bool deallocate(const key_type& key)
+    {
+        auto memory = get(key);
+        if(memory == nullptr)
+        {
+            return false;
+        }
+        auto index = size_type(key_traits::get_index(key));
+        auto& block = blocks_[index];
+        if(block.destroy != nullptr)
+        {
+            auto destroy = block.destroy;
+            block.destroy = nullptr;
+            destroy(memory);
+        }
+
+        key_traits::increment_generation(block.key);
+        --size_;
+        if(!key_traits::is_exhausted(block.key))
+        {
+            std::memcpy(memory, &free_head_, sizeof(free_head_));
+            free_head_ = index;
+        }
+        return true;
+    }
+
+private:
+    struct block_info
+    {
+        key_type key{};                 // only the generation is used
+        void (*destroy)(void*){};       // set for blocks made by create()
+    };
+
+    struct page
+    {
+        std::unique_ptr<unsigned char[]> storage;
+        unsigned char* blocks{}; // storage aligned to block_alignment_
+    };
+
+    static constexpr size_type no_block = size_type(-1);
+
+    static size_type round_up(size_type value, size_type alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    static bool is_live(const key_type& key)
+    {
+        return (key_traits::get_generation(key) & 1) != 0;
+    }
+
+    void* address(size_type index) const
+    {
+        return pages_[index / blocks_per_page_].blocks + (index % blocks_per_page_) * block_size_;
+    }
+
+    void add_page()
+    {
+        page p;
+        p.storage.reset(new unsigned char[blocks_per_page_ * block_size_ + block_alignment_ - 1]);
+        auto address = reinterpret_cast<uintptr_t>(p.storage.get());
+        p.blocks = p.storage.get() + (round_up(address, block_alignment_) - address);
+        pages_.push_back(std::move(p));
+    }
+
+    key_type allocate_block()
+    {
+        size_type index;
+        if(free_head_ != no_block)
+        {
+            index = free_head_;
+            std::memcpy(&free_head_, address(index), sizeof(free_head_));
+        }
+        else
+        {
+            index = blocks_.size();
+            if(index >= key_traits::max_slots())
+            {
+                SLOT_MAP_THROW_EXCEPTION(std::length_error, "generational_arena handle index space exhausted");
+            }
+            if(index == capacity())
+            {
+                add_page();
+            }
+            blocks_.emplace_back();
+        }
+
+        auto& block = blocks_[index];
+        block.destroy = nullptr;
+        key_traits::increment_generation(block.key);
+        ++size_;
+
+        key_type key = block.key;
+        key_traits::set_index(key, index);
+        return key;
+    }
+
+    size_type block_alignment_;
+    size_type block_size_;
+    size_type blocks_per_page_;
+
+    std::vector<page> pages_;
+    std::vector<block_info> blocks_;
+    size_type free_head_{no_block};
+    size_type size_{};
+};
+
+} // namespace hpp
@@ -0,0 +1,245 @@
+#pragma once
+#include "event.hpp"
+#include "ring_buffer.hpp"
+#include "span.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace hpp
+{
+/// Queueing policies of queued_event.
+///
+/// queue_all keeps every emitted argument tuple, in order.
+/// queue_coalesce skips a tuple equal to the last queued one.
+/// queue_latest keeps only the last tuple.
+struct queue_all
+{
+};
+struct queue_coalesce
+{
+};
+struct queue_latest
+{
+};
+
+template<typename T, typename Policy = queue_all>
+class queued_event;
+
+/// An event whose emit() only stores the arguments. flush() delivers
+/// everything queued since the last flush, typically once per frame.
+///
+/// The arguments are copied into a ring buffer preallocated by the
+/// constructor, so the queue itself never allocates. When the ring is full
+/// the oldest tuple is dropped and counted by dropped(). The ring holds
+/// value-initialized tuples that emit() assigns over, so every argument type
+/// must be default constructible.
+///
+/// Slots are connected with the usual event API and get one call per queued
+/// tuple. Batch slots connected with connect_batch() get the queued tuples
+/// as contiguous spans instead: one call, or two when the queue wrapped
+/// around the end of the ring.
+///
+/// Tuples emitted while flushing go to a second ring and are delivered by
+/// the next flush.
+///
+/// If a slot throws, flush() stops and rethrows. The tuples after the one
+/// being delivered stay queued, ahead of those emitted since, and go out
+/// with the next flush; the batch slots never see the ones delivered before
+/// the throw. If a batch slot throws, the slots already got every tuple and
+/// the queue is cleared.
+///
+/// The event is a private base, so an emit through an event& can not skip
+/// the queue.
+template<typename Policy, typename... Args>
+class queued_event<void(Args...), Policy> : private hpp::event<void(Args...)>
+{
+    using base_type = hpp::event<void(Args...)>;
+
+public:
+    using typename base_type::slot_type;
+    using typename base_type::slot_key;
+    using typename base_type::slot_sentinel;
+    using typename base_type::slot_priority;
+    using typename base_type::connection;
+
+    using base_type::connect;
+    using base_type::disconnect;
+    using base_type::disconnect_current;
+    using base_type::make_connection;
+    using base_type::empty;
+
+    using value_type = std::tuple<typename std::decay<Args>::type...>;
+    using batch_type = hpp::span<const value_type>;
+    using batch_slot_key = typename hpp::event<void(batch_type)>::slot_key;
+
+    static_assert(std::is_default_constructible<value_type>::value,
+                  "queued_event needs default constructible argument types");
+
+    explicit queued_event(size_t capacity = 256)
+        : queues_{{0, 0, (std::max)(capacity, size_t(1))}, {0, 0, (std::max)(capacity, size_t(1))}}
+    {
+    }
+
+    /// Queues a copy of the arguments. O(1).
+    void emit(Args... args)
+    {
+        push(Policy{}, value_type(args...));
+    }
+
+    void operator()(Args... args)
+    {
+        emit(args...);
+    }
+
+    /// Delivers the queued tuples, first to the slots, one call per tuple,
+    /// then to the batch slots. Does nothing when called from a slot.
+    void flush()
+    {
+        const auto flushed = active_;
+        auto& queue = queues_[flushed];
+        if(flushing_ || queue.empty())
+        {
+            return;
+        }
+        flushing_ = true;
+        active_ ^= 1;
+
+        // tuples the slots are done with, kept by requeue() otherwise
+        size_t delivered{};
+        try
+        {
+            if(!base_type::empty())
+            {
+                for(const auto& value : queue)
+                {
+                    delivered++;
+                    emit_tuple(value, std::index_sequence_for<Args...>{});
+                }
+            }
+            delivered = queue.size();
+
+            if(!batch_event_.empty())
+            {
+                const auto& data = queue.container();
+                const auto first = queue.front_idx();
+                const auto head = (std::min)(queue.size(), data.size() - first);
+                batch_event_.emit(batch_type(data.data() + first, head));
+                if(head < queue.size())
+                {
+                    batch_event_.emit(batch_type(data.data(), queue.size() - head));
+                }
+            }
+        }
+        catch(...)
+        {
+            flushing_ = false;
+            requeue(flushed, delivered);
+            throw;
+        }
+
+        queue.clear();
+        flushing_ = false;
+    }
+
+    /// Drops the queued tuples without delivering them.
+    void discard()
+    {
+        queues_[active_].clear();
+    }
+
+    template<typename T>
+    batch_slot_key connect_batch(T&& f, const hpp::source_location& location = hpp::source_location::current())
+    {
+        return batch_event_.connect(std::forward<T>(f), location);
+    }
+
+    void disconnect_batch(const batch_slot_key& key)
+    {
+        batch_event_.disconnect(key);
+    }
+
+    /// Tuples waiting for the next flush.
+    size_t queued() const
+    {
+        return queues_[active_].size();
+    }
+
+    size_t capacity() const
+    {
+        return queues_[active_].capacity();
+    }
+
+    /// Tuples dropped because the ring was full, since construction.
+    uint64_t dropped() const
+    {
+        return dropped_;
+    }
+
+private:
+    void push(queue_all, value_type&& value)
+    {
+        auto& queue = queues_[active_];
+        if(queue.full())
+        {
+            dropped_++;
+        }
+        queue.push_back(std::move(value));
+    }
+
+    void push(queue_coalesce, value_type&& value)
+    {
+        auto& queue = queues_[active_];
+        if(!queue.empty() && queue.back() == value)
+        {
+            return;
+        }
+        push(queue_all{}, std::move(value));
+    }
+
+    void push(queue_latest, value_type&& value)
+    {
+        auto& queue = queues_[active_];
+        if(!queue.empty())
+        {
+            queue.back() = std::move(value);
+            return;
+        }
+        queue.push_back(std::move(value));
+    }
+
+    // Makes the flushed ring active again, without its first delivered
+    // tuples and followed by the ones emitted during the flush.
+    void requeue(size_t flushed, size_t delivered)
+    {
+        auto& queue = queues_[flushed];
+        auto& emitted = queues_[flushed ^ 1];
+        for(; delivered > 0 && !queue.empty(); --delivered)
+        {
+            queue.pop_front();
+        }
+
+        active_ = flushed;
+        for(auto& value : emitted)
+        {
+            push(Policy{}, std::move(value));
+        }
+        emitted.clear();
+    }
+
+    template<size_t... I>
+    void emit_tuple(const value_type& value, std::index_sequence<I...>) const
+    {
+        base_type::emit(std::get<I>(value)...);
+    }
+
+    heap_ringbuffer<value_type> queues_[2];
+    size_t active_{};
+    bool flushing_{};
+    uint64_t dropped_{};
+    hpp::event<void(batch_type)> batch_event_;
+};
+
+} // end of namespace hpp
@@ -1,11 +1,208 @@
+#pragma once
+
+#include "detail/cpu_features.hpp"
+#include "span.hpp"
+
+#include <array>
 #include <cstdint>
 #include <cstring>
 
+// The armv8 path needs the crypto extension enabled at compile time
+// (e.g. -march=armv8-a+crypto), availability is still checked at runtime.
+#if defined(HPP_ARCH_ARM64_LINUX) && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2))
+#define HPP_SHA1_ARM_CRYPTO
+#include <arm_neon.h>
+#endif
+
 namespace hpp
 {
 #define SHA1_HEX_SIZE (40 + 1)
 #define SHA1_BASE64_SIZE (28 + 1)
 
+namespace detail
+{
+#ifdef HPP_ARCH_X86
+// Block function on the x86 SHA extensions. Each SHA1_NI_ROUNDS step does four
+// rounds while scheduling the message words needed three steps later.
+HPP_TARGET("sha,sse4.1")
+inline void sha1_process_blocks_shani(uint32_t (&state)[5], const uint8_t* ptr, size_t blocks)
+{
+	const __m128i mask = _mm_set_epi64x(0x0001020304050607ll, 0x08090a0b0c0d0e0fll);
+
+	__m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0x1b);
+	__m128i e0 = _mm_set_epi32(static_cast<int>(state[4]), 0, 0, 0);
+	__m128i e1;
+	__m128i msg0;
+	__m128i msg1;
+	__m128i msg2;
+	__m128i msg3;
+
+#define SHA1_NI_LOAD(msg, offset)                                                                            \
+	msg = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + offset)), mask);
+#define SHA1_NI_ROUNDS(e, e_next, m0, m1, m2, m3, f)                                                         \
+	e = _mm_sha1nexte_epu32(e, m0);                                                                          \
+	e_next = abcd;                                                                                           \
+	m1 = _mm_sha1msg2_epu32(m1, m0);                                                                         \
+	abcd = _mm_sha1rnds4_epu32(abcd, e, f);                                                                  \
+	m3 = _mm_sha1msg1_epu32(m3, m0);                                                                         \
+	m2 = _mm_xor_si128(m2, m0);
+
+	for(; blocks; blocks--, ptr += 64)
+	{
+		const __m128i abcd_save = abcd;
+		const __m128i e0_save = e0;
+
+		// rounds 0-11
+		SHA1_NI_LOAD(msg0, 0)
+		e0 = _mm_add_epi32(e0, msg0);
+		e1 = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+
+		SHA1_NI_LOAD(msg1, 16)
+		e1 = _mm_sha1nexte_epu32(e1, msg1);
+		e0 = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+		msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+
+		SHA1_NI_LOAD(msg2, 32)
+		e0 = _mm_sha1nexte_epu32(e0, msg2);
+		e1 = abcd;
+		abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+		msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+		msg0 = _mm_xor_si128(msg0, msg2);
+
+		// rounds 12-79
+		SHA1_NI_LOAD(msg3, 48)
+		SHA1_NI_ROUNDS(e1, e0, msg3, msg0, msg1, msg2, 0)
+		SHA1_NI_ROUNDS(e0, e1, msg0, msg1, msg2, msg3, 0)
+		SHA1_NI_ROUNDS(e1, e0, msg1, msg2, msg3, msg0, 1)
+		SHA1_NI_ROUNDS(e0, e1, msg2, msg3, msg0, msg1, 1)
+		SHA1_NI_ROUNDS(e1, e0, msg3, msg0, msg1, msg2, 1)
+		SHA1_NI_ROUNDS(e0, e1, msg0, msg1, msg2, msg3, 1)
+		SHA1_NI_ROUNDS(e1, e0, msg1, msg2, msg3, msg0, 1)
+		SHA1_NI_ROUNDS(e0, e1, msg2, msg3, msg0, msg1, 2)
+		SHA1_NI_ROUNDS(e1, e0, msg3, msg0, msg1, msg2, 2)
+		SHA1_NI_ROUNDS(e0, e1, msg0, msg1, msg2, msg3, 2)
+		SHA1_NI_ROUNDS(e1, e0, msg1, msg2, msg3, msg0, 2)
+		SHA1_NI_ROUNDS(e0, e1, msg2, msg3, msg0, msg1, 2)
+		SHA1_NI_ROUNDS(e1, e0, msg3, msg0, msg1, msg2, 3)
+		SHA1_NI_ROUNDS(e0, e1, msg0, msg1, msg2, msg3, 3)
+		SHA1_NI_ROUNDS(e1, e0, msg1, msg2, msg3, msg0, 3)
+		SHA1_NI_ROUNDS(e0, e1, msg2, msg3, msg0, msg1, 3)
+		SHA1_NI_ROUNDS(e1, e0, msg3, msg0, msg1, msg2, 3)
+
+		e0 = _mm_sha1nexte_epu32(e0, e0_save);
+		abcd = _mm_add_epi32(abcd, abcd_save);
+	}
+
+#undef SHA1_NI_LOAD
+#undef SHA1_NI_ROUNDS
+
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_shuffle_epi32(abcd, 0x1b));
+	state[4] = static_cast<uint32_t>(_mm_extract_epi32(e0, 3));
+}
+#endif
+
+#ifdef HPP_SHA1_ARM_CRYPTO
+// Block function on the armv8 sha1 instructions. Each SHA1_ARM_ROUNDS step does
+// four rounds, prepares the constants two steps ahead and the message words
+// three and four steps ahead.
+inline void sha1_process_blocks_arm(uint32_t (&state)[5], const uint8_t* ptr, size_t blocks)
+{
+	const uint32x4_t k0 = vdupq_n_u32(0x5a827999);
+	const uint32x4_t k1 = vdupq_n_u32(0x6ed9eba1);
+	const uint32x4_t k2 = vdupq_n_u32(0x8f1bbcdc);
+	const uint32x4_t k3 = vdupq_n_u32(0xca62c1d6);
+
+	uint32x4_t abcd = vld1q_u32(state);
+	uint32_t e0 = state[4];
+	uint32_t e1;
+	uint32x4_t tmp0;
+	uint32x4_t tmp1;
+	uint32x4_t msg0;
+	uint32x4_t msg1;
+	uint32x4_t msg2;
+	uint32x4_t msg3;
+
+#define SHA1_ARM_LOAD(msg, offset) msg = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(ptr + offset)));
+#define SHA1_ARM_ROUNDS(op, e, e_next, tmp, k, m0, m1, m2, m3)                                              \
+	e_next = vsha1h_u32(vgetq_lane_u32(abcd, 0));                                                            \
+	abcd = op(abcd, e, tmp);                                                                                 \
+	tmp = vaddq_u32(m2, k);                                                                                  \
+	m3 = vsha1su1q_u32(m3, m2);                                                                              \
+	m0 = vsha1su0q_u32(m0, m1, m2);
+
+	for(; blocks; blocks--, ptr += 64)
+	{
+		const uint32x4_t abcd_save = abcd;
+		const uint32_t e0_save = e0;
+
+		SHA1_ARM_LOAD(msg0, 0)
+		SHA1_ARM_LOAD(msg1, 16)
+		SHA1_ARM_LOAD(msg2, 32)
+		SHA1_ARM_LOAD(msg3, 48)
+
+		tmp0 = vaddq_u32(msg0, k0);
+		tmp1 = vaddq_u32(msg1, k0);
+
+		// rounds 0-3, the first message words need no sigma1 step yet
+		e1 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+		abcd = vsha1cq_u32(abcd, e0, tmp0);
+		tmp0 = vaddq_u32(msg2, k0);
+		msg0 = vsha1su0q_u32(msg0, msg1, msg2);
+
+		// rounds 4-79
+		SHA1_ARM_ROUNDS(vsha1cq_u32, e1, e0, tmp1, k0, msg1, msg2, msg3, msg0)
+		SHA1_ARM_ROUNDS(vsha1cq_u32, e0, e1, tmp0, k0, msg2, msg3, msg0, msg1)
+		SHA1_ARM_ROUNDS(vsha1cq_u32, e1, e0, tmp1, k1, msg3, msg0, msg1, msg2)
+		SHA1_ARM_ROUNDS(vsha1cq_u32, e0, e1, tmp0, k1, msg0, msg1, msg2, msg3)
+		SHA1_ARM_ROUNDS(vsha1pq_u32, e1, e0, tmp1, k1, msg1, msg2, msg3, msg0)
+		SHA1_ARM_ROUNDS(vsha1pq_u32, e0, e1, tmp0, k1, msg2, msg3, msg0, msg1)
+		SHA1_ARM_ROUNDS(vsha1pq_u32, e1, e0, tmp1, k1, msg3, msg0, msg1, msg2)
+		SHA1_ARM_ROUNDS(vsha1pq_u32, e0, e1, tmp0, k2, msg0, msg1, msg2, msg3)
+		SHA1_ARM_ROUNDS(vsha1pq_u32, e1, e0, tmp1, k2, msg1, msg2, msg3, msg0)
+		SHA1_ARM_ROUNDS(vsha1mq_u32, e0, e1, tmp0, k2, msg2, msg3, msg0, msg1)
+		SHA1_ARM_ROUNDS(vsha1mq_u32, e1, e0, tmp1, k2, msg3, msg0, msg1, msg2)
+		SHA1_ARM_ROUNDS(vsha1mq_u32, e0, e1, tmp0, k2, msg0, msg1, msg2, msg3)
+		SHA1_ARM_ROUNDS(vsha1mq_u32, e1, e0, tmp1, k3, msg1, msg2, msg3, msg0)
+		SHA1_ARM_ROUNDS(vsha1mq_u32, e0, e1, tmp0, k3, msg2, msg3, msg0, msg1)
+		SHA1_ARM_ROUNDS(vsha1pq_u32, e1, e0, tmp1, k3, msg3, msg0, msg1, msg2)
+		SHA1_ARM_ROUNDS(vsha1pq_u32, e0, e1, tmp0, k3, msg0, msg1, msg2, msg3)
+		SHA1_ARM_ROUNDS(vsha1pq_u32, e1, e0, tmp1, k3, msg1, msg2, msg3, msg0)
+		SHA1_ARM_ROUNDS(vsha1pq_u32, e0, e1, tmp0, k3, msg2, msg3, msg0, msg1)
+		SHA1_ARM_ROUNDS(vsha1pq_u32, e1, e0, tmp1, k3, msg3, msg0, msg1, msg2)
+
+		e0 += e0_save;
+		abcd = vaddq_u32(abcd, abcd_save);
+	}
+
+#undef SHA1_ARM_LOAD
+#undef SHA1_ARM_ROUNDS
+
+	vst1q_u32(state, abcd);
+	state[4] = e0;
+}
+#endif
+
+// Builds the final one or two padded blocks of a message of size bytes whose
+// last size % 64 bytes start at rest. Returns the number of tail blocks.
+inline size_t sha1_make_tail(uint8_t (&tail)[128], const uint8_t* rest, uint64_t size)
+{
+	const size_t rest_size = static_cast<size_t>(size % 64);
+	const size_t tail_size = rest_size < 56 ? 64 : 128;
+	if(rest_size)
+		memcpy(tail, rest, rest_size);
+	tail[rest_size] = 0x80;
+	memset(tail + rest_size + 1, 0, tail_size - rest_size - 1);
+	const uint64_t n_bits = size * 8;
+	for(int j = 0; j < 8; j++)
+		tail[tail_size - 1 - j] = static_cast<uint8_t>(n_bits >> j * 8);
+	return tail_size / 64;
+}
+} // namespace detail
+
+using sha1_digest = std::array<uint32_t, 5>;
+
 class sha1
 {
 private:
@@ -31,7 +228,37 @@ private:
 			   ((uint32_t)p[3] << 0 * 8);
 	}
 
+	static void process_blocks(uint32_t (&state)[5], const uint8_t* ptr, size_t blocks)
+	{
+#if defined(HPP_ARCH_X86)
+		const auto& features = detail::get_cpu_features();
+		if(features.sha && features.sse41)
+		{
+			detail::sha1_process_blocks_shani(state, ptr, blocks);
+			return;
+		}
+#elif defined(HPP_SHA1_ARM_CRYPTO)
+		if(detail::get_cpu_features().sha)
+		{
+			detail::sha1_process_blocks_arm(state, ptr, blocks);
+			return;
+		}
+#endif
+		for(; blocks; blocks--, ptr += 64)
+			process_block_portable(state, ptr);
+	}
+
+	void process_blocks(const uint8_t* ptr, size_t blocks)
+	{
+		process_blocks(state, ptr, blocks);
+	}
+
 	void process_block(const uint8_t* ptr)
+	{
+		process_blocks(state, ptr, 1);
+	}
+
+	static void process_block_portable(uint32_t (&state)[5], const uint8_t* ptr)
 	{
 		const uint32_t c0 = 0x5a827999;
 		const uint32_t c1 = 0x6ed9eba1;
@@ -196,22 +423,37 @@ public:
 			return *this;
 
 		const auto* ptr = reinterpret_cast<const uint8_t*>(data);
+		n_bits += uint64_t(n) * 8;
 
 		// fill up block if not full
-		for(; n && i % sizeof(buf); n--)
-			add(*ptr++);
+		if(i)
+		{
+			const size_t take = n < sizeof(buf) - i ? n : sizeof(buf) - i;
+			memcpy(buf + i, ptr, take);
+			i += static_cast<uint32_t>(take);
+			ptr += take;
+			n -= take;
+			if(i < sizeof(buf))
+				return *this;
+			i = 0;
+			process_block(buf);
+		}
 
-		// process full blocks
-		for(; n >= sizeof(buf); n -= sizeof(buf))
+		// process full blocks straight from the caller's memory
+		const size_t blocks = n / sizeof(buf);
+		if(blocks)
 		{
-			process_block(ptr);
-			ptr += sizeof(buf);
-			n_bits += sizeof(buf) * 8;
+			process_blocks(ptr, blocks);
+			ptr += blocks * sizeof(buf);
+			n -= blocks * sizeof(buf);
 		}
 
-		// process remaining part of block
-		for(; n; n--)
-			add(*ptr++);
+		// keep the remaining part of block
+		if(n)
+		{
+			memcpy(buf, ptr, n);
+			i = static_cast<uint32_t>(n);
+		}
 
 		return *this;
 	}
@@ -226,15 +468,37 @@ public:
 	sha1& finalize()
 	{
 		// hashed text ends with 0x80, some padding 0x00 and the length in bits
-		add_byte_dont_count_bits(0x80);
-		while(i % 64 != 56)
-			add_byte_dont_count_bits(0x00);
-		for(int j = 7; j >= 0; j--)
-			add_byte_dont_count_bits(n_bits >> j * 8);
+		uint8_t tail[128];
+		const size_t blocks = detail::sha1_make_tail(tail, buf, n_bits / 8);
+		process_blocks(tail, blocks);
+		i = 0;
 
 		return *this;
 	}
 
+	// One-shot hash that skips the buffering state machine: whole blocks are
+	// processed in place and only the padded tail is copied.
+	static sha1_digest hash_once(const void* data, size_t n)
+	{
+		uint32_t st[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+		const auto* ptr = reinterpret_cast<const uint8_t*>(data);
+		const size_t blocks = ptr ? n / 64 : 0;
+		if(blocks)
+			process_blocks(st, ptr, blocks);
+
+		uint8_t tail[128];
+		const size_t tail_blocks = detail::sha1_make_tail(tail, ptr + blocks * 64, ptr ? n : 0);
+		process_blocks(st, tail, tail_blocks);
+
+		return {{st[0], st[1], st[2], st[3], st[4]}};
+	}
+
+	static sha1_digest hash_once(span<const uint8_t> data)
+	{
+		return hash_once(data.data(), data.size());
+	}
+
 	const sha1& print_hex(char* hex, bool zero_terminate = true,
 						  bool uppercase = true) const
 	{
@@ -244,11 +508,11 @@ public:
         const char* alphabet = uppercase ? alphabet_upper : alphabet_lower;
 		// print hex
 		int k = 0;
-		for(int i = 0; i < 5; i++)
+		for(int word = 0; word < 5; word++)
 		{
 			for(int j = 7; j >= 0; j--)
 			{
-				hex[k++] = alphabet[(state[i] >> j * 4) & 0xf];
+				hex[k++] = alphabet[(state[word] >> j * 4) & 0xf];
 			}
 		}
 		if(zero_terminate)
@@ -273,13 +537,13 @@ public:
 			((state[4] & 0x0000ffff) << 1 * 8),
 		};
 
-		for(int i = 0; i < 7; i++)
+		for(int t = 0; t < 7; t++)
 		{
-			uint32_t x = triples[i];
-			base64[i * 4 + 0] = table[(x >> 3 * 6) % 64];
-			base64[i * 4 + 1] = table[(x >> 2 * 6) % 64];
-			base64[i * 4 + 2] = table[(x >> 1 * 6) % 64];
-			base64[i * 4 + 3] = table[(x >> 0 * 6) % 64];
+			uint32_t x = triples[t];
+			base64[t * 4 + 0] = table[(x >> 3 * 6) % 64];
+			base64[t * 4 + 1] = table[(x >> 2 * 6) % 64];
+			base64[t * 4 + 2] = table[(x >> 1 * 6) % 64];
+			base64[t * 4 + 3] = table[(x >> 0 * 6) % 64];
 		}
 
 		base64[SHA1_BASE64_SIZE - 2] = '=';
@@ -288,4 +552,220 @@ public:
 		return *this;
 	}
 };
+
+namespace detail
+{
+// Multi-buffer sha1: the same block function is run on N independent messages
+// at once, one message per 32 bit vector lane. Written with the gcc/clang
+// vector extensions so a single kernel serves all vector widths.
+#if defined(HPP_ARCH_X86) && (defined(__GNUC__) || defined(__clang__))
+#define HPP_SHA1_MULTI_BUFFER
+
+typedef uint32_t sha1_u32x4 __attribute__((vector_size(16)));
+typedef uint32_t sha1_u32x8 __attribute__((vector_size(32)));
+typedef uint32_t sha1_u32x16 __attribute__((vector_size(64)));
+
+template <typename V, size_t N>
+HPP_FORCE_INLINE void sha1_lanes_process_block(uint32_t (&state)[5][N], const uint32_t (&block)[16][N])
+{
+	static_assert(sizeof(V) == N * sizeof(uint32_t), "lane count mismatch");
+
+	V w[16];
+	for(int i = 0; i < 16; i++)
+		memcpy(&w[i], block[i], sizeof(V));
+
+	V s[5];
+	for(int i = 0; i < 5; i++)
+		memcpy(&s[i], state[i], sizeof(V));
+
+	V a = s[0];
+	V b = s[1];
+	V c = s[2];
+	V d = s[3];
+	V e = s[4];
+
+#define SHA1_LANES_ROL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+#define SHA1_LANES_LOAD(i)                                                                                   \
+	w[i & 15] = SHA1_LANES_ROL(w[(i + 13) & 15] ^ w[(i + 8) & 15] ^ w[(i + 2) & 15] ^ w[i & 15], 1);
+#define SHA1_LANES_ROUND(f, k, i)                                                                            \
+	{                                                                                                        \
+		V t = SHA1_LANES_ROL(a, 5) + (f) + e + w[i & 15] + (k);                                              \
+		e = d;                                                                                               \
+		d = c;                                                                                               \
+		c = SHA1_LANES_ROL(b, 30);                                                                           \
+		b = a;                                                                                               \
+		a = t;                                                                                               \
+	}
+
+	for(int i = 0; i < 16; i++)
+		SHA1_LANES_ROUND(((c ^ d) & b) ^ d, 0x5a827999u, i)
+	for(int i = 16; i < 20; i++)
+	{
+		SHA1_LANES_LOAD(i)
+		SHA1_LANES_ROUND(((c ^ d) & b) ^ d, 0x5a827999u, i)
+	}
+	for(int i = 20; i < 40; i++)
+	{
+		SHA1_LANES_LOAD(i)
+		SHA1_LANES_ROUND(b ^ c ^ d, 0x6ed9eba1u, i)
+	}
+	for(int i = 40; i < 60; i++)
+	{
+		SHA1_LANES_LOAD(i)
+		SHA1_LANES_ROUND(((b | c) & d) | (b & c), 0x8f1bbcdcu, i)
+	}
+	for(int i = 60; i < 80; i++)
+	{
+		SHA1_LANES_LOAD(i)
+		SHA1_LANES_ROUND(b ^ c ^ d, 0xca62c1d6u, i)
+	}
+
+#undef SHA1_LANES_ROL
+#undef SHA1_LANES_LOAD
+#undef SHA1_LANES_ROUND
+
+	s[0] += a;
+	s[1] += b;
+	s[2] += c;
+	s[3] += d;
+	s[4] += e;
+	for(int i = 0; i < 5; i++)
+		memcpy(state[i], &s[i], sizeof(V));
+}
+
+// Every lane walks the padded block sequence of one message. When a lane
+// finishes, its digest is written out and the next pending message takes its
+// place, so uneven message lengths do not leave lanes idle.
+template <typename V, size_t N>
+HPP_FORCE_INLINE void sha1_batch_lanes(const span<const uint8_t>* messages, size_t count, sha1_digest* digests)
+{
+	struct lane_t
+	{
+		const uint8_t* data{};
+		size_t full_blocks{};
+		size_t blocks{};
+		size_t block{};
+		size_t message{};
+		bool active{};
+		uint8_t tail[128]{};
+	};
+
+	static const uint8_t idle_block[64]{};
+
+	lane_t lanes[N];
+	alignas(64) uint32_t state[5][N];
+	alignas(64) uint32_t block[16][N];
+	size_t next = 0;
+	size_t active = 0;
+
+	auto start_lane = [&](size_t l)
+	{
+		auto& lane = lanes[l];
+		lane.active = next < count;
+		if(!lane.active)
+			return;
+
+		const auto& msg = messages[next];
+		lane.data = msg.data();
+		lane.full_blocks = msg.size() / 64;
+		const auto* rest = lane.data + lane.full_blocks * 64;
+		lane.blocks = lane.full_blocks + sha1_make_tail(lane.tail, rest, msg.size());
+		lane.block = 0;
+		lane.message = next++;
+
+		state[0][l] = 0x67452301;
+		state[1][l] = 0xEFCDAB89;
+		state[2][l] = 0x98BADCFE;
+		state[3][l] = 0x10325476;
+		state[4][l] = 0xC3D2E1F0;
+		++active;
+	};
+
+	for(size_t l = 0; l < N; l++)
+		start_lane(l);
+
+	while(active)
+	{
+		for(size_t l = 0; l < N; l++)
+		{
+			const auto& lane = lanes[l];
+			const uint8_t* ptr = idle_block;
+			if(lane.active)
+			{
+				ptr = lane.block < lane.full_blocks ? lane.data + lane.block * 64
+													: lane.tail + (lane.block - lane.full_blocks) * 64;
+			}
+			for(int i = 0; i < 16; i++, ptr += 4)
+			{
+				block[i][l] = ((uint32_t)ptr[0] << 24) | ((uint32_t)ptr[1] << 16) |
+							  ((uint32_t)ptr[2] << 8) | ((uint32_t)ptr[3]);
+			}
+		}
+
+		sha1_lanes_process_block<V, N>(state, block);
+
+		for(size_t l = 0; l < N; l++)
+		{
+			auto& lane = lanes[l];
+			if(!lane.active || ++lane.block != lane.blocks)
+				continue;
+
+			auto& digest = digests[lane.message];
+			for(int i = 0; i < 5; i++)
+				digest[i] = state[i][l];
+			--active;
+			start_lane(l);
+		}
+	}
+}
+
+HPP_TARGET("sse2")
+inline void sha1_batch_sse2(const span<const uint8_t>* messages, size_t count, sha1_digest* digests)
+{
+	sha1_batch_lanes<sha1_u32x4, 4>(messages, count, digests);
+}
+
+HPP_TARGET("avx2")
+inline void sha1_batch_avx2(const span<const uint8_t>* messages, size_t count, sha1_digest* digests)
+{
+	sha1_batch_lanes<sha1_u32x8, 8>(messages, count, digests);
+}
+
+HPP_TARGET("avx512f")
+inline void sha1_batch_avx512(const span<const uint8_t>* messages, size_t count, sha1_digest* digests)
+{
+	sha1_batch_lanes<sha1_u32x16, 16>(messages, count, digests);
+}
+#endif
+
+inline void sha1_batch_scalar(const span<const uint8_t>* messages, size_t count, sha1_digest* digests)
+{
+	for(size_t m = 0; m < count; m++)
+	{
+		digests[m] = sha1::hash_once(messages[m]);
+	}
+}
+} // namespace detail
+
+// Hashes many independent messages at once. digests[i] receives the same
+// words as sha1::state after hashing messages[i] and calling finalize().
+// Uses 16/8/4 vector lanes (AVX-512/AVX2/SSE2) when available.
+// With the SHA extensions only the 16 lane kernel is worth it.
+// Only min(messages.size(), digests.size()) messages are processed.
+inline void sha1_batch(span<const span<const uint8_t>> messages, span<sha1_digest> digests)
+{
+	const size_t count = messages.size() < digests.size() ? messages.size() : digests.size();
+#ifdef HPP_SHA1_MULTI_BUFFER
+	const auto& features = detail::get_cpu_features();
+	if(count >= 16 && features.avx512f)
+		return detail::sha1_batch_avx512(messages.data(), count, digests.data());
+	// a single stream on the SHA extensions outruns the narrower lane kernels
+	if(!features.sha && count >= 8 && features.avx2)
+		return detail::sha1_batch_avx2(messages.data(), count, digests.data());
+	if(!features.sha && count >= 2)
+		return detail::sha1_batch_sse2(messages.data(), count, digests.data());
+#endif
+	detail::sha1_batch_scalar(messages.data(), count, digests.data());
+}
+
 } //end of namespace hpp
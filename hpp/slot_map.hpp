@@ -1,5 +1,13 @@
 #pragma once
 
+#include "span.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -12,9 +20,11 @@
 namespace hpp
 {
 
-template <class T, class Key = std::pair<unsigned, unsigned>,
-          template <class...> class Container = std::vector>
-class slot_map
+// How slot_map reads and updates its keys. The primary template handles any
+// pair or tuple-like (index, generation) key. Specialize it for key types
+// that are not tuple-like, see packed_key below.
+template <class Key>
+struct slot_map_key_traits
 {
 #if __cplusplus >= 201703L
     static auto get_index(const Key& k)
@@ -53,7 +63,8 @@ class slot_map
     static void set_index(Key& k, Integral value)
     {
         using std::get;
-        get<0>(k) = key_size_type(value);
+        using index_type = typename std::decay<decltype(get<0>(k))>::type;
+        get<0>(k) = index_type(value);
     }
     static void increment_generation(Key& k)
     {
@@ -62,6 +73,197 @@ class slot_map
     }
 #endif
 
+    // Called on a slot right after its generation was incremented by an erase.
+    // An exhausted slot is retired instead of going back on the free list,
+    // so keys with a wrapped generation can never alias an older key.
+    static bool is_exhausted(const Key&)
+    {
+        return false;
+    }
+    // The free list links slots by index, so one index value is kept spare.
+    static constexpr size_t max_slots()
+    {
+        return size_t(std::numeric_limits<decltype(get_index(std::declval<Key>()))>::max());
+    }
+};
+
+// A slot_map key packed into one unsigned integer: the slot index in the low
+// IndexBits bits and the generation in the remaining high bits.
+//
+// packed_key32 holds 2^20 - 1 slots and 4096 generations in 4 bytes,
+// packed_key64 holds 2^32 - 1 slots and 2^32 generations in 8 bytes.
+// When a slot's generation wraps around the slot is retired until clear(),
+// so a stale key never matches the slot's new value.
+template <class UInt, unsigned IndexBits>
+class packed_key
+{
+    static_assert(std::is_unsigned<UInt>::value, "packed_key needs an unsigned integer type");
+    static_assert(IndexBits > 0 && IndexBits < sizeof(UInt) * 8, "packed_key needs index and generation bits");
+
+public:
+    using value_type = UInt;
+
+    static constexpr unsigned index_bits = IndexBits;
+    static constexpr unsigned generation_bits = sizeof(UInt) * 8 - IndexBits;
+    static constexpr UInt index_mask = (UInt(1) << IndexBits) - 1;
+    static constexpr UInt generation_mask = UInt(~UInt(0)) >> IndexBits;
+
+    constexpr packed_key() noexcept = default;
+    constexpr packed_key(UInt index, UInt generation) noexcept
+        : value_(UInt((index & index_mask) | UInt((generation & generation_mask) << IndexBits)))
+    {
+    }
+
+    // The raw packed value, for storing keys in serialized data.
+    constexpr UInt value() const noexcept
+    {
+        return value_;
+    }
+    static constexpr packed_key from_value(UInt value) noexcept
+    {
+        packed_key key;
+        key.value_ = value;
+        return key;
+    }
+
+    constexpr UInt index() const noexcept
+    {
+        return value_ & index_mask;
+    }
+    constexpr UInt generation() const noexcept
+    {
+        return value_ >> IndexBits;
+    }
+
+    friend constexpr bool operator==(packed_key lhs, packed_key rhs) noexcept
+    {
+        return lhs.value_ == rhs.value_;
+    }
+    friend constexpr bool operator!=(packed_key lhs, packed_key rhs) noexcept
+    {
+        return lhs.value_ != rhs.value_;
+    }
+    friend constexpr bool operator<(packed_key lhs, packed_key rhs) noexcept
+    {
+        return lhs.value_ < rhs.value_;
+    }
+
+private:
+    UInt value_{};
+};
+
+using packed_key32 = packed_key<uint32_t, 20>;
+using packed_key64 = packed_key<uint64_t, 32>;
+
+template <class UInt, unsigned IndexBits>
+struct slot_map_key_traits<packed_key<UInt, IndexBits>>
+{
+    using key_type = packed_key<UInt, IndexBits>;
+
+    static UInt get_index(key_type k)
+    {
+        return k.index();
+    }
+    static UInt get_generation(key_type k)
+    {
+        return k.generation();
+    }
+    template <class Integral>
+    static void set_index(key_type& k, Integral value)
+    {
+        k = key_type(UInt(value), k.generation());
+    }
+    static void increment_generation(key_type& k)
+    {
+        k = key_type(k.index(), UInt(k.generation() + 1));
+    }
+    static bool is_exhausted(key_type k)
+    {
+        return k.generation() == 0;
+    }
+    static constexpr size_t max_slots()
+    {
+        return size_t(key_type::index_mask);
+    }
+};
+
+namespace detail
+{
+// The slot free list shared by slot_map and basic_soa_slot_map. A free slot
+// holds the index of the next free slot in its key index, free_head is the
+// first free slot, and free_head == slots.size() means the next slot is a new
+// one. A live slot holds the position of its value.
+
+// Takes the first free slot (or makes a new one, starting at first_generation)
+// for the value at value_pos and returns its key. Throws std::length_error,
+// with nothing changed, when the key index space is exhausted.
+template <class Key, class Slots, class Index, class Generation>
+Key bind_free_slot(Slots& slots, Index& free_head, size_t value_pos, Generation first_generation)
+{
+    using key_traits = slot_map_key_traits<Key>;
+    if(size_t(free_head) == slots.size())
+    {
+        if(slots.size() >= key_traits::max_slots())
+        {
+            SLOT_MAP_THROW_EXCEPTION(std::length_error, "slot_map key index space exhausted");
+        }
+        auto idx = free_head;
+        ++idx;
+        slots.emplace_back(Key{idx, first_generation}); // make a new slot
+    }
+    auto slot_index = size_t(free_head);
+    auto& slot = *std::next(slots.begin(), slot_index);
+    free_head = Index(key_traits::get_index(slot));
+    key_traits::set_index(slot, value_pos);
+    key_traits::increment_generation(slot);
+    Key result = slot;
+    key_traits::set_index(result, slot_index);
+    return result;
+}
+
+// Expires the key of a slot and puts the slot on the free list, unless its
+// generation is exhausted.
+template <class Key, class Slots, class Index>
+void release_slot(Slots& slots, Index& free_head, size_t slot_index)
+{
+    using key_traits = slot_map_key_traits<Key>;
+    auto& slot = *std::next(slots.begin(), slot_index);
+    key_traits::increment_generation(slot);
+    if(key_traits::is_exhausted(slot))
+    {
+        return;
+    }
+    key_traits::set_index(slot, free_head);
+    free_head = Index(slot_index);
+}
+} // namespace detail
+
+// Container can be hpp::chunked_vector (chunked_vector.hpp) when growth must
+// not move the values or cause an O(n) reallocation spike.
+template <class T, class Key = std::pair<unsigned, unsigned>,
+          template <class...> class Container = std::vector>
+class slot_map
+{
+    using key_traits = slot_map_key_traits<Key>;
+
+    static auto get_index(const Key& k)
+    {
+        return key_traits::get_index(k);
+    }
+    static auto get_generation(const Key& k)
+    {
+        return key_traits::get_generation(k);
+    }
+    template <class Integral>
+    static void set_index(Key& k, Integral value)
+    {
+        key_traits::set_index(k, value);
+    }
+    static void increment_generation(Key& k)
+    {
+        key_traits::increment_generation(k);
+    }
+
     using slot_iterator = typename Container<Key>::iterator;
 
 public:
@@ -136,13 +338,8 @@ public:
     //
     iterator find(const key_type& key)
     {
-        auto slot_index = get_index(key);
-        if(slot_index >= slots_.size())
-        {
-            return end();
-        }
-        auto slot_iter = std::next(slots_.begin(), get_index(key));
-        if(get_generation(*slot_iter) != get_generation(key))
+        auto slot_iter = this->find_slot(key);
+        if(slot_iter == slots_.cend())
         {
             return end();
         }
@@ -151,8 +348,8 @@ public:
     }
     const_iterator find(const key_type& key) const
     {
-        auto slot_iter = std::next(slots_.begin(), get_index(key));
-        if(get_generation(*slot_iter) != get_generation(key))
+        auto slot_iter = this->find_slot(key);
+        if(slot_iter == slots_.cend())
         {
             return end();
         }
@@ -160,6 +357,38 @@ public:
         return value_iter;
     }
 
+    // Checked lookup of many keys at once: out[i] points to the value of
+    // keys[i], or is nullptr if the check fails. Resolves min(keys.size(),
+    // out.size()) keys.
+    // The slots of later keys are prefetched while earlier keys are checked.
+    // The values are not touched, use visit_many() to read them.
+    // O(n) time, O(1) space complexity.
+    //
+    void find_many(span<const key_type> keys, span<pointer> out)
+    {
+        this->find_many_impl(*this, keys, out);
+    }
+    void find_many(span<const key_type> keys, span<const_pointer> out) const
+    {
+        this->find_many_impl(*this, keys, out);
+    }
+
+    // Calls function(i, value) for every keys[i] that passes the checks, in
+    // order. Here the values are read right away, so the loop prefetches
+    // both the slot and the value of keys further ahead.
+    // O(n) time, O(1) space complexity.
+    //
+    template <class Function>
+    void visit_many(span<const key_type> keys, Function&& function)
+    {
+        this->visit_many_impl(*this, keys, function);
+    }
+    template <class Function>
+    void visit_many(span<const key_type> keys, Function&& function) const
+    {
+        this->visit_many_impl(*this, keys, function);
+    }
+
     // The find_unchecked() functions perform no checks of any kind.
     // O(1) time and space complexity.
     //
@@ -227,6 +456,15 @@ public:
         return values_.rend();
     }
 
+    // The key of the value at value_index.
+    key_type key_at(size_type value_index) const
+    {
+        auto slot_index = *std::next(reverse_map_.begin(), value_index);
+        key_type key = *std::next(slots_.begin(), slot_index);
+        this->set_index(key, slot_index);
+        return key;
+    }
+
     // Functions for checking the size and capacity of the adapted container
     // have the same complexity as the adapted container.
     // reserve(n) has the complexity of the adapted container, and uses
@@ -267,6 +505,77 @@ public:
         return slots_.capacity();
     }
 
+    // Drops the free slots at the end of the slot array (the high water mark
+    // left by a burst of inserts), rebuilds the free list in index order and
+    // releases unused capacity of all containers. Every live key stays valid.
+    // Retired slots are kept, so their keys never come back.
+    // A slot that is dropped and made again later starts past the highest
+    // generation dropped so far, so stale keys stay stale.
+    // O(high_water_mark()) time, O(high_water_mark() / 64) extra space.
+    //
+    void shrink_to_fit()
+    {
+        constexpr size_type word_bits = 64;
+        const auto slot_count = size_type(slots_.size());
+        std::vector<uint64_t> live((slot_count + word_bits - 1) / word_bits);
+        for(const auto& slot_index : reverse_map_)
+        {
+            live[size_type(slot_index) / word_bits] |= uint64_t(1) << (size_type(slot_index) % word_bits);
+        }
+        auto is_live = [&live](size_type index)
+        {
+            return (live[index / word_bits] >> (index % word_bits)) & 1;
+        };
+        auto is_retired = [this](size_type index)
+        {
+            return key_traits::is_exhausted(*std::next(slots_.begin(), index));
+        };
+
+        auto new_count = slot_count;
+        for(; new_count > 0 && !is_live(new_count - 1) && !is_retired(new_count - 1); --new_count)
+        {
+            auto generation = get_generation(*std::next(slots_.begin(), new_count - 1));
+            if(generation_floor_ < generation)
+            {
+                generation_floor_ = generation;
+            }
+        }
+        slots_.erase(std::next(slots_.begin(), new_count), slots_.end());
+
+        next_available_slot_index_ = key_size_type(new_count);
+        for(auto index = new_count; index-- > 0;)
+        {
+            if(!is_live(index) && !is_retired(index))
+            {
+                this->set_index(*std::next(slots_.begin(), index), next_available_slot_index_);
+                next_available_slot_index_ = key_size_type(index);
+            }
+        }
+
+        slots_.shrink_to_fit();
+        reverse_map_.shrink_to_fit();
+        values_.shrink_to_fit();
+    }
+
+    // Bytes held by each container (capacity, not size) and the number of
+    // slots without a value (free or retired). O(1).
+    struct memory_usage_info
+    {
+        size_type slots_bytes;
+        size_type reverse_map_bytes;
+        size_type values_bytes;
+        size_type free_slot_count;
+    };
+    memory_usage_info memory_usage() const
+    {
+        memory_usage_info usage{};
+        usage.slots_bytes = size_type(slots_.capacity()) * sizeof(key_type);
+        usage.reverse_map_bytes = size_type(reverse_map_.capacity()) * sizeof(key_size_type);
+        usage.values_bytes = size_type(values_.capacity()) * sizeof(mapped_type);
+        usage.free_slot_count = size_type(slots_.size()) - size();
+        return usage;
+    }
+
     // These operations have O(1) time and space complexity.
     // When size() == capacity() an allocation is required
     // which has O(n) time and space complexity.
@@ -285,20 +594,41 @@ public:
     {
         auto value_pos = values_.size();
         values_.emplace_back(std::forward<Args>(args)...);
-        reverse_map_.emplace_back(next_available_slot_index_);
-        if(next_available_slot_index_ == slots_.size())
+        return this->bind_slot(value_pos);
+    }
+
+    // Batch versions of emplace() and insert(). Storage is reserved once for
+    // the whole batch and the key of the i-th new value is written to keys[i].
+    // O(n) time for n values, plus at most one reallocation per container.
+    //
+    // emplace_n() constructs keys.size() values from the same arguments.
+    template <typename... Args>
+    void emplace_n(span<key_type> keys, const Args&... args)
+    {
+        this->reserve_for_batch(keys.size());
+        for(auto& key : keys)
+        {
+            auto value_pos = values_.size();
+            values_.emplace_back(args...);
+            key = this->bind_slot(value_pos);
+        }
+    }
+    // Inserts every value of [first, last). keys must have room for all of them.
+    template <class ForwardIt>
+    void insert_range(ForwardIt first, ForwardIt last, span<key_type> keys)
+    {
+        auto count = static_cast<size_type>(std::distance(first, last));
+        if(keys.size() < count)
         {
-            auto idx = next_available_slot_index_;
-            ++idx;
-            slots_.emplace_back(key_type{idx, key_generation_type{}}); // make a new slot
+            SLOT_MAP_THROW_EXCEPTION(std::length_error, "insert_range");
+        }
+        this->reserve_for_batch(count);
+        for(auto key_iter = keys.begin(); first != last; ++first, ++key_iter)
+        {
+            auto value_pos = values_.size();
+            values_.emplace_back(*first);
+            *key_iter = this->bind_slot(value_pos);
         }
-        auto slot_iter = std::next(slots_.begin(), next_available_slot_index_);
-        next_available_slot_index_ = this->get_index(*slot_iter);
-        this->set_index(*slot_iter, value_pos);
-        this->increment_generation(*slot_iter);
-        key_type result = *slot_iter;
-        this->set_index(result, std::distance(slots_.begin(), slot_iter));
-        return result;
     }
 
     // Each erase() version has an O(1) time complexity per value
@@ -341,6 +671,69 @@ public:
         return 1;
     }
 
+    // Erases the values of all valid keys and returns how many were erased.
+    // Stale and duplicate keys are skipped.
+    // The erased value positions are collected and sorted first. Then the
+    // positions below the new size are refilled from the surviving tail
+    // values, and the tail is dropped in one go. Every surviving value moves
+    // at most once.
+    // O(k log k) time and O(k) space for k keys.
+    //
+    size_type erase_many(span<const key_type> keys)
+    {
+        std::vector<size_type> erased;
+        erased.reserve(keys.size());
+        for(const auto& key : keys)
+        {
+            if(this->find(key) == this->end())
+            {
+                continue;
+            }
+            // Expire the key right away, so a duplicate of it fails find().
+            auto slot_index = get_index(key);
+            auto slot_iter = std::next(slots_.begin(), slot_index);
+            erased.push_back(size_type(get_index(*slot_iter)));
+            this->expire_slot(slot_iter);
+        }
+        if(erased.empty())
+        {
+            return 0;
+        }
+        std::sort(erased.begin(), erased.end());
+
+        const auto count = erased.size();
+        const auto new_size = values_.size() - count;
+        auto back = values_.size();
+        auto tail = count; // erased[tail - 1] is the highest erased position below back
+        for(auto hole : erased)
+        {
+            if(hole >= new_size)
+            {
+                break;
+            }
+            // Find the last value that survives.
+            for(;;)
+            {
+                --back;
+                if(tail > 0 && erased[tail - 1] == back)
+                {
+                    --tail;
+                    continue;
+                }
+                break;
+            }
+
+            *std::next(values_.begin(), hole) = std::move(*std::next(values_.begin(), back));
+            auto slot_index = *std::next(reverse_map_.begin(), back);
+            *std::next(reverse_map_.begin(), hole) = slot_index;
+            this->set_index(*std::next(slots_.begin(), slot_index), hole);
+        }
+
+        values_.erase(std::next(values_.begin(), new_size), values_.end());
+        reverse_map_.erase(std::next(reverse_map_.begin(), new_size), reverse_map_.end());
+        return count;
+    }
+
     // clear() has O(n) time complexity and O(1) space complexity.
     // It also has semantics differing from erase(begin(), end())
     // in that it also resets the generation counter of every slot
@@ -354,6 +747,7 @@ public:
         values_.clear();
         reverse_map_.clear();
         next_available_slot_index_ = key_size_type{};
+        generation_floor_ = key_generation_type{};
     }
 
     // swap is not mentioned in P0661r1 but it should be.
@@ -364,6 +758,112 @@ public:
         swap(values_, rhs.values_);
         swap(reverse_map_, rhs.reverse_map_);
         swap(next_available_slot_index_, rhs.next_available_slot_index_);
+        swap(generation_floor_, rhs.generation_floor_);
+    }
+
+    // Binary snapshots. The snapshot holds the slots, the reverse map, the
+    // values and the free list head as they are in memory, so every key
+    // stays valid after a load. Each block is written and read back with a
+    // single copy of its bytes, with no per element construction, so a buffer
+    // from a memory mapped snapshot file can be passed straight to
+    // load_snapshot(). The loaded map owns its memory, the buffer is not
+    // referenced afterwards.
+    //
+    // Only available when T and Key are trivially copyable and Container is
+    // contiguous (has data()). The layout is native, so snapshots are only portable
+    // between builds with the same T, Key and byte order. load_snapshot()
+    // checks the header, the block sizes against the input and every slot and
+    // reverse map index, and returns false (leaving the map unchanged) if
+    // anything does not match. The values themselves are taken as they are.
+    //
+    // save_snapshot_to() and load_snapshot_from() write and read through
+    // callbacks, write(const void*, size_t) and read(void*, size_t), which
+    // return false on failure. The std::ostream and std::istream versions are
+    // in slot_map_stream.hpp.
+    //
+    size_type snapshot_size() const
+    {
+        return size_type(sizeof(snapshot_header) + slots_.size() * sizeof(key_type) +
+                         reverse_map_.size() * sizeof(key_size_type) + values_.size() * sizeof(mapped_type));
+    }
+    // out must hold at least snapshot_size() bytes. Returns the bytes written.
+    size_type save_snapshot(span<uint8_t> out) const
+    {
+        const auto total = snapshot_size();
+        if(out.size() < total)
+        {
+            SLOT_MAP_THROW_EXCEPTION(std::length_error, "save_snapshot");
+        }
+        auto pos = out.data();
+        this->save_snapshot_to(
+            [&pos](const void* data, size_t size)
+            {
+                pos = copy_bytes(pos, data, size);
+                return true;
+            });
+        return total;
+    }
+    template <class Writer>
+    bool save_snapshot_to(Writer&& write) const
+    {
+        check_snapshot_types();
+        auto header = make_snapshot_header();
+        return write(&header, sizeof(header)) && write(slots_.data(), slots_.size() * sizeof(key_type)) &&
+               write(reverse_map_.data(), reverse_map_.size() * sizeof(key_size_type)) &&
+               write(values_.data(), values_.size() * sizeof(mapped_type));
+    }
+    bool load_snapshot(span<const uint8_t> in)
+    {
+        check_snapshot_types();
+        snapshot_header header;
+        if(in.size() < sizeof(header))
+        {
+            return false;
+        }
+        std::memcpy(&header, in.data(), sizeof(header));
+        if(!is_valid_snapshot_header(header))
+        {
+            return false;
+        }
+        // checked by division, the counts come from the input
+        auto remaining = uint64_t(in.size() - sizeof(header));
+        if(header.slot_count > remaining / sizeof(key_type))
+        {
+            return false;
+        }
+        remaining -= header.slot_count * sizeof(key_type);
+        if(header.value_count > remaining / (sizeof(key_size_type) + sizeof(mapped_type)))
+        {
+            return false;
+        }
+
+        slot_map loaded;
+        auto pos = in.data() + sizeof(header);
+        pos = append_bytes(loaded.slots_, pos, size_type(header.slot_count));
+        pos = append_bytes(loaded.reverse_map_, pos, size_type(header.value_count));
+        append_bytes(loaded.values_, pos, size_type(header.value_count));
+        return this->take_snapshot(loaded, header);
+    }
+    template <class Reader>
+    bool load_snapshot_from(Reader&& read)
+    {
+        check_snapshot_types();
+        snapshot_header header;
+        if(!read(&header, sizeof(header)) || !is_valid_snapshot_header(header))
+        {
+            return false;
+        }
+
+        // The blocks grow as their bytes arrive, so the counts of a truncated
+        // or forged snapshot cannot make the load allocate up front.
+        slot_map loaded;
+        if(!read_block(read, loaded.slots_, header.slot_count) ||
+           !read_block(read, loaded.reverse_map_, header.value_count) ||
+           !read_block(read, loaded.values_, header.value_count))
+        {
+            return false;
+        }
+        return this->take_snapshot(loaded, header);
     }
 
 protected:
@@ -387,6 +887,314 @@ protected:
     }
 
 private:
+    struct snapshot_header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t key_size;
+        uint32_t index_size;
+        uint64_t value_size;
+        uint64_t slot_count;
+        uint64_t value_count;
+        uint64_t next_available_slot_index;
+        uint64_t generation_floor;
+    };
+    // "hpsm", reads back byte swapped on a host with the other byte order
+    static constexpr uint32_t snapshot_magic = 0x6d737068;
+    static constexpr uint32_t snapshot_version = 2;
+
+    static void check_snapshot_types()
+    {
+        static_assert(std::is_trivially_copyable<mapped_type>::value, "snapshots need a trivially copyable T");
+        // std::pair is not trivially copyable (its assignment is user provided)
+        // but copying its bytes is fine
+        static_assert(std::is_trivially_copy_constructible<key_type>::value &&
+                          std::is_trivially_destructible<key_type>::value,
+                      "snapshots need a trivially copyable Key");
+    }
+
+    snapshot_header make_snapshot_header() const
+    {
+        snapshot_header header{};
+        header.magic = snapshot_magic;
+        header.version = snapshot_version;
+        header.key_size = uint32_t(sizeof(key_type));
+        header.index_size = uint32_t(sizeof(key_size_type));
+        header.value_size = sizeof(mapped_type);
+        header.slot_count = slots_.size();
+        header.value_count = values_.size();
+        header.next_available_slot_index = uint64_t(next_available_slot_index_);
+        header.generation_floor = uint64_t(generation_floor_);
+        return header;
+    }
+
+    static bool is_valid_snapshot_header(const snapshot_header& header)
+    {
+        return header.magic == snapshot_magic && header.version == snapshot_version &&
+               header.key_size == sizeof(key_type) && header.index_size == sizeof(key_size_type) &&
+               header.value_size == sizeof(mapped_type) && header.value_count <= header.slot_count &&
+               header.next_available_slot_index <= header.slot_count &&
+               header.slot_count <= key_traits::max_slots();
+    }
+
+    static uint8_t* copy_bytes(uint8_t* out, const void* in, size_t size)
+    {
+        if(size != 0)
+        {
+            std::memcpy(out, in, size);
+        }
+        return out + size;
+    }
+
+    // Elements per chunk when a block has to go through an aligned buffer.
+    template <class Element>
+    static constexpr size_t snapshot_chunk_elements()
+    {
+        return sizeof(Element) >= 16384 ? 1 : 16384 / sizeof(Element);
+    }
+
+    // Appends count elements stored as bytes at in and returns the end of
+    // them. A single copy if in is aligned for the element type, otherwise
+    // the bytes go through an aligned buffer.
+    template <class C>
+    static const uint8_t* append_bytes(C& container, const uint8_t* in, size_t count)
+    {
+        using element = typename C::value_type;
+        container.reserve(container.size() + count);
+        if(reinterpret_cast<uintptr_t>(in) % alignof(element) == 0)
+        {
+            auto first = reinterpret_cast<const element*>(in);
+            container.insert(container.end(), first, first + count);
+            return in + count * sizeof(element);
+        }
+
+        constexpr auto chunk_elements = snapshot_chunk_elements<element>();
+        alignas(element) uint8_t buffer[chunk_elements * sizeof(element)];
+        while(count > 0)
+        {
+            const auto n = (std::min)(count, chunk_elements);
+            std::memcpy(buffer, in, n * sizeof(element));
+            auto first = reinterpret_cast<const element*>(buffer);
+            container.insert(container.end(), first, first + n);
+            in += n * sizeof(element);
+            count -= n;
+        }
+        return in;
+    }
+
+    template <class Reader, class C>
+    static bool read_block(Reader& read, C& container, uint64_t count)
+    {
+        using element = typename C::value_type;
+        constexpr auto chunk_elements = snapshot_chunk_elements<element>();
+        alignas(element) uint8_t buffer[chunk_elements * sizeof(element)];
+        while(count > 0)
+        {
+            const auto n = size_t((std::min)(count, uint64_t(chunk_elements)));
+            if(!read(static_cast<void*>(buffer), n * sizeof(element)))
+            {
+                return false;
+            }
+            auto first = reinterpret_cast<const element*>(buffer);
+            container.insert(container.end(), first, first + n);
+            count -= n;
+        }
+        return true;
+    }
+
+    // Moves a loaded snapshot into this map if its indices are consistent.
+    bool take_snapshot(slot_map& loaded, const snapshot_header& header)
+    {
+        loaded.next_available_slot_index_ = key_size_type(header.next_available_slot_index);
+        loaded.generation_floor_ = key_generation_type(header.generation_floor);
+        if(!loaded.has_consistent_indices())
+        {
+            return false;
+        }
+        this->swap(loaded);
+        return true;
+    }
+
+    // Every value's slot points back at it, exactly the slots of values have
+    // odd (live) generations, and the free list stays in range, holds no live
+    // slot and ends at slots_.size(). O(n) time and O(n) bits.
+    bool has_consistent_indices() const
+    {
+        const auto slot_count = size_type(slots_.size());
+        std::vector<bool> live(slot_count);
+        for(size_type value_index = 0; value_index < values_.size(); ++value_index)
+        {
+            const auto slot_index = size_type(*std::next(reverse_map_.begin(), value_index));
+            if(slot_index >= slot_count || live[slot_index] ||
+               size_type(get_index(*std::next(slots_.begin(), slot_index))) != value_index)
+            {
+                return false;
+            }
+            live[slot_index] = true;
+        }
+
+        // live slots have odd generations, so a key can only match a live slot
+        for(size_type slot_index = 0; slot_index < slot_count; ++slot_index)
+        {
+            const auto generation = uint64_t(get_generation(*std::next(slots_.begin(), slot_index)));
+            if(((generation & 1) != 0) != live[slot_index])
+            {
+                return false;
+            }
+        }
+        if((uint64_t(generation_floor_) & 1) != 0)
+        {
+            return false;
+        }
+
+        auto free_slots = slot_count - values_.size();
+        for(auto index = size_type(next_available_slot_index_); index != slot_count;
+            index = size_type(get_index(*std::next(slots_.begin(), index))))
+        {
+            if(index > slot_count || live[index] || free_slots-- == 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    using const_slot_iterator = typename Container<Key>::const_iterator;
+
+    // Returns slots_.cend() unless the key passes the bounds and generation checks.
+    const_slot_iterator find_slot(const key_type& key) const
+    {
+        auto slot_index = get_index(key);
+        if(slot_index >= slots_.size())
+        {
+            return slots_.cend();
+        }
+        auto slot_iter = std::next(slots_.cbegin(), slot_index);
+        if(get_generation(*slot_iter) != get_generation(key))
+        {
+            return slots_.cend();
+        }
+        return slot_iter;
+    }
+
+    static void prefetch(const void* address)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(address);
+#else
+        (void)address;
+#endif
+    }
+
+    // How many keys ahead find_many() prefetches slots. Values are
+    // prefetched half as far ahead.
+    static constexpr size_type prefetch_distance = 16;
+
+    template <class Self, class Pointer>
+    static void find_many_impl(Self& self, span<const key_type> keys, span<Pointer> out)
+    {
+        const auto count = (std::min)(size_type(keys.size()), size_type(out.size()));
+        for(size_type i = 0; i < count; ++i)
+        {
+            if(i + prefetch_distance < count)
+            {
+                self.prefetch_slot(keys[i + prefetch_distance]);
+            }
+            auto slot_iter = self.find_slot(keys[i]);
+            out[i] = slot_iter == self.slots_.cend()
+                         ? nullptr
+                         : &*std::next(self.values_.begin(), get_index(*slot_iter));
+        }
+    }
+
+    template <class Self, class Function>
+    static void visit_many_impl(Self& self, span<const key_type> keys, Function& function)
+    {
+        const auto count = size_type(keys.size());
+        for(size_type i = 0; i < count; ++i)
+        {
+            if(i + prefetch_distance < count)
+            {
+                self.prefetch_slot(keys[i + prefetch_distance]);
+            }
+            if(i + prefetch_distance / 2 < count)
+            {
+                self.prefetch_value(keys[i + prefetch_distance / 2]);
+            }
+            auto slot_iter = self.find_slot(keys[i]);
+            if(slot_iter != self.slots_.cend())
+            {
+                function(i, *std::next(self.values_.begin(), get_index(*slot_iter)));
+            }
+        }
+    }
+
+    void prefetch_slot(const key_type& key) const
+    {
+        auto slot_index = get_index(key);
+        if(slot_index < slots_.size())
+        {
+            prefetch(&*std::next(slots_.cbegin(), slot_index));
+        }
+    }
+    // Only issued once the slot is expected to be cached, it reads the slot.
+    void prefetch_value(const key_type& key) const
+    {
+        auto slot_index = get_index(key);
+        if(slot_index < slots_.size())
+        {
+            auto value_index = get_index(*std::next(slots_.cbegin(), slot_index));
+            if(value_index < values_.size())
+            {
+                prefetch(&*std::next(values_.cbegin(), value_index));
+            }
+        }
+    }
+
+    // Takes a slot from the free list (or makes a new one) for the value at
+    // value_pos, the last value. The value is popped again if that fails.
+    key_type bind_slot(size_type value_pos)
+    {
+        try
+        {
+            reverse_map_.emplace_back(next_available_slot_index_);
+        }
+        catch(...)
+        {
+            values_.pop_back();
+            throw;
+        }
+        try
+        {
+            return detail::bind_free_slot<key_type>(slots_, next_available_slot_index_, value_pos,
+                                                    generation_floor_);
+        }
+        catch(...)
+        {
+            reverse_map_.pop_back();
+            values_.pop_back();
+            throw;
+        }
+    }
+
+    // Every live value holds one slot, so n more values need at most size() + n slots.
+    void reserve_for_batch(size_type n)
+    {
+        grow_to(values_, values_.size() + n);
+        grow_to(reverse_map_, reverse_map_.size() + n);
+        grow_to(slots_, values_.size() + n);
+    }
+    // Grows geometrically, so a loop of small batches does not reallocate
+    // on every call.
+    template <class C>
+    static void grow_to(C& container, size_type needed)
+    {
+        if(container.capacity() < needed)
+        {
+            container.reserve((std::max)(needed, size_type(2 * container.capacity())));
+        }
+    }
+
     slot_iterator slot_iter_from_value_iter(const_iterator value_iter)
     {
         auto value_index = std::distance(const_iterator(values_.begin()), value_iter);
@@ -395,7 +1203,6 @@ private:
     }
     iterator erase_slot_iter(slot_iterator slot_iter)
     {
-        auto slot_index = std::distance(slots_.begin(), slot_iter);
         auto value_index = get_index(*slot_iter);
         auto value_iter = std::next(values_.begin(), value_index);
         auto value_back_iter = std::prev(values_.end());
@@ -409,23 +1216,36 @@ private:
         }
         values_.pop_back();
         reverse_map_.pop_back();
-        // Expire this key.
-        this->set_index(*slot_iter, next_available_slot_index_);
-        this->increment_generation(*slot_iter);
-        next_available_slot_index_ = slot_index;
+        this->expire_slot(slot_iter);
         return std::next(values_.begin(), value_index);
     }
 
+    void expire_slot(slot_iterator slot_iter)
+    {
+        detail::release_slot<key_type>(slots_, next_available_slot_index_,
+                                       size_t(std::distance(slots_.begin(), slot_iter)));
+    }
+
     Container<key_type> slots_;            // high_water_mark() entries
     Container<key_size_type> reverse_map_; // exactly size() entries
     Container<mapped_type> values_;        // exactly size() entries
     key_size_type next_available_slot_index_{};
+    key_generation_type generation_floor_{}; // first generation of new slots, see shrink_to_fit()
 };
 
 } // namespace hpp
 
 namespace std
 {
+template <class UInt, unsigned IndexBits>
+struct hash<hpp::packed_key<UInt, IndexBits>>
+{
+    size_t operator()(hpp::packed_key<UInt, IndexBits> key) const noexcept
+    {
+        return hash<UInt>()(key.value());
+    }
+};
+
 template <class T, class Key, template <class...> class Container>
 void swap(hpp::slot_map<T, Key, Container>& lhs, hpp::slot_map<T, Key, Container>& rhs)
 {
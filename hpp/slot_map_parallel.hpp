@@ -0,0 +1,82 @@
+#pragma once
+
+#include "slot_map.hpp"
+#include "work_stealing_pool.hpp"
+
+#include <iterator>
+
+namespace hpp
+{
+
+// Data parallel loops over a slot_map, kept out of slot_map.hpp so that
+// slot_map users do not pull in the threading headers.
+//
+// parallel_for_each() calls function(value) for every value. The dense value
+// array is cut into chunks of grain values, which run on the threads of pool.
+// The chunk boundaries do not depend on the thread count, see
+// work_stealing_pool. function is shared by all threads and must not insert
+// or erase.
+// O(n / threads) time, O(threads) space complexity.
+//
+template <class T, class Key, template <class...> class Container, class Function>
+void parallel_for_each(slot_map<T, Key, Container>& map, Function&& function, size_t grain = 4096,
+                       work_stealing_pool& pool = work_stealing_pool::shared())
+{
+    pool.parallel_for(size_t(map.size()), grain,
+                      [&map, &function](size_t begin, size_t end)
+                      {
+                          auto value_iter = std::next(map.begin(), begin);
+                          for(auto i = begin; i < end; ++i, ++value_iter)
+                          {
+                              function(*value_iter);
+                          }
+                      });
+}
+template <class T, class Key, template <class...> class Container, class Function>
+void parallel_for_each(const slot_map<T, Key, Container>& map, Function&& function, size_t grain = 4096,
+                       work_stealing_pool& pool = work_stealing_pool::shared())
+{
+    pool.parallel_for(size_t(map.size()), grain,
+                      [&map, &function](size_t begin, size_t end)
+                      {
+                          auto value_iter = std::next(map.begin(), begin);
+                          for(auto i = begin; i < end; ++i, ++value_iter)
+                          {
+                              function(*value_iter);
+                          }
+                      });
+}
+
+// Same as parallel_for_each() but calls function(key, value). The keys are
+// rebuilt from the reverse map with slot_map::key_at().
+//
+template <class T, class Key, template <class...> class Container, class Function>
+void parallel_for_each_with_key(slot_map<T, Key, Container>& map, Function&& function, size_t grain = 4096,
+                                work_stealing_pool& pool = work_stealing_pool::shared())
+{
+    pool.parallel_for(size_t(map.size()), grain,
+                      [&map, &function](size_t begin, size_t end)
+                      {
+                          auto value_iter = std::next(map.begin(), begin);
+                          for(auto i = begin; i < end; ++i, ++value_iter)
+                          {
+                              function(map.key_at(i), *value_iter);
+                          }
+                      });
+}
+template <class T, class Key, template <class...> class Container, class Function>
+void parallel_for_each_with_key(const slot_map<T, Key, Container>& map, Function&& function,
+                                size_t grain = 4096, work_stealing_pool& pool = work_stealing_pool::shared())
+{
+    pool.parallel_for(size_t(map.size()), grain,
+                      [&map, &function](size_t begin, size_t end)
+                      {
+                          auto value_iter = std::next(map.begin(), begin);
+                          for(auto i = begin; i < end; ++i, ++value_iter)
+                          {
+                              function(map.key_at(i), *value_iter);
+                          }
+                      });
+}
+
+} // namespace hpp
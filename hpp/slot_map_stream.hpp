@@ -0,0 +1,37 @@
+#pragma once
+
+#include "slot_map.hpp"
+
+#include <istream>
+#include <ostream>
+
+namespace hpp
+{
+
+// std::ostream and std::istream versions of the slot_map snapshot functions,
+// kept out of slot_map.hpp so that slot_map users do not pull in the stream
+// headers. See slot_map::save_snapshot() for the format.
+
+template <class T, class Key, template <class...> class Container>
+bool save_snapshot(const slot_map<T, Key, Container>& map, std::ostream& out)
+{
+    return map.save_snapshot_to(
+        [&out](const void* data, size_t size)
+        {
+            return bool(out.write(static_cast<const char*>(data), std::streamsize(size)));
+        });
+}
+
+// Returns false, leaving map unchanged, if the stream ends early or the
+// snapshot does not match map's types or is inconsistent.
+template <class T, class Key, template <class...> class Container>
+bool load_snapshot(slot_map<T, Key, Container>& map, std::istream& in)
+{
+    return map.load_snapshot_from(
+        [&in](void* data, size_t size)
+        {
+            return bool(in.read(static_cast<char*>(data), std::streamsize(size)));
+        });
+}
+
+} // namespace hpp
@@ -0,0 +1,289 @@
+#pragma once
+
+#include "slot_map.hpp"
+#include "span.hpp"
+#include "utility/for_each.hpp"
+
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace hpp
+{
+
+// A slot_map that stores each field of its values in its own dense array
+// (structure of arrays). Keys, generation checks, the free list and the
+// reverse map work exactly like in slot_map, including swap-and-pop erase,
+// which is applied to every column so row i of all columns always belongs
+// to the same key.
+//
+// column<I>() exposes field I as a contiguous span, so a system that only
+// touches one or two fields streams through just those arrays.
+//
+//     hpp::soa_slot_map<position, velocity, health> entities;
+//     auto key = entities.emplace(position{}, velocity{}, health{100});
+//     auto positions = entities.column<0>();
+//     auto velocities = entities.column<1>();
+//     for(size_t i = 0; i < positions.size(); ++i)
+//         positions[i] += velocities[i];
+//
+template <class Key, class... Ts>
+class basic_soa_slot_map
+{
+    static_assert(sizeof...(Ts) > 0, "soa_slot_map needs at least one column");
+
+    using key_traits = slot_map_key_traits<Key>;
+
+    static auto get_index(const Key& k)
+    {
+        return key_traits::get_index(k);
+    }
+    static auto get_generation(const Key& k)
+    {
+        return key_traits::get_generation(k);
+    }
+
+public:
+    using key_type = Key;
+    using size_type = size_t;
+    using key_size_type = decltype(get_index(std::declval<Key>()));
+    using key_generation_type = decltype(get_generation(std::declval<Key>()));
+
+    template <size_t I>
+    using column_type = typename std::tuple_element<I, std::tuple<Ts...>>::type;
+
+    static constexpr size_type npos = size_type(-1);
+
+    // Takes one argument per column and constructs each field from it.
+    // If constructing a field or binding the key throws, the fields already
+    // added are removed again and the map is unchanged.
+    // O(1) amortized time.
+    //
+    template <class... Args>
+    key_type emplace(Args&&... args)
+    {
+        static_assert(sizeof...(Args) == sizeof...(Ts), "emplace takes one argument per column");
+        auto value_pos = size();
+        emplace_columns(std::index_sequence_for<Ts...>{}, std::forward<Args>(args)...);
+        try
+        {
+            reverse_map_.emplace_back(next_available_slot_index_);
+            try
+            {
+                return detail::bind_free_slot<key_type>(slots_, next_available_slot_index_, value_pos,
+                                                        key_generation_type{});
+            }
+            catch(...)
+            {
+                reverse_map_.pop_back();
+                throw;
+            }
+        }
+        catch(...)
+        {
+            pop_columns(sizeof...(Ts));
+            throw;
+        }
+    }
+    key_type insert(const Ts&... values)
+    {
+        return emplace(values...);
+    }
+
+    // Returns the row of the key's fields in every column, or npos if the
+    // key fails the bounds or generation check. O(1).
+    //
+    size_type index_of(const key_type& key) const
+    {
+        auto slot_index = size_type(get_index(key));
+        if(slot_index >= slots_.size())
+        {
+            return npos;
+        }
+        const auto& slot = slots_[slot_index];
+        if(get_generation(slot) != get_generation(key))
+        {
+            return npos;
+        }
+        return size_type(get_index(slot));
+    }
+    bool contains(const key_type& key) const
+    {
+        return index_of(key) != npos;
+    }
+
+    // The key of the fields in row index. O(1).
+    key_type key_at(size_type index) const
+    {
+        auto slot_index = reverse_map_[index];
+        auto key = slots_[slot_index];
+        key_traits::set_index(key, slot_index);
+        return key;
+    }
+
+    // Field I of the key, nullptr if the check fails.
+    template <size_t I>
+    column_type<I>* find(const key_type& key)
+    {
+        auto index = index_of(key);
+        return index == npos ? nullptr : &std::get<I>(columns_)[index];
+    }
+    template <size_t I>
+    const column_type<I>* find(const key_type& key) const
+    {
+        auto index = index_of(key);
+        return index == npos ? nullptr : &std::get<I>(columns_)[index];
+    }
+    // Field I of the key, throws std::out_of_range if the check fails.
+    template <size_t I>
+    column_type<I>& at(const key_type& key)
+    {
+        auto value = find<I>(key);
+        if(value == nullptr)
+        {
+            SLOT_MAP_THROW_EXCEPTION(std::out_of_range, "at");
+        }
+        return *value;
+    }
+    template <size_t I>
+    const column_type<I>& at(const key_type& key) const
+    {
+        auto value = find<I>(key);
+        if(value == nullptr)
+        {
+            SLOT_MAP_THROW_EXCEPTION(std::out_of_range, "at");
+        }
+        return *value;
+    }
+
+    // Every value of field I, densely packed. Row i of every column belongs
+    // to key_at(i). Invalidated by emplace and erase.
+    template <size_t I>
+    span<column_type<I>> column()
+    {
+        auto& c = std::get<I>(columns_);
+        return span<column_type<I>>(c.data(), c.size());
+    }
+    template <size_t I>
+    span<const column_type<I>> column() const
+    {
+        const auto& c = std::get<I>(columns_);
+        return span<const column_type<I>>(c.data(), c.size());
+    }
+
+    // Moves the last row into the erased one in every column. O(1).
+    size_type erase(const key_type& key)
+    {
+        auto value_index = index_of(key);
+        if(value_index == npos)
+        {
+            return 0;
+        }
+        auto slot_index = size_type(get_index(key));
+        auto last_index = size() - 1;
+
+        hpp::for_each(columns_,
+                      [value_index, last_index](auto& column)
+                      {
+                          if(value_index != last_index)
+                          {
+                              column[value_index] = std::move(column[last_index]);
+                          }
+                          column.pop_back();
+                      });
+        if(value_index != last_index)
+        {
+            auto moved_slot_index = reverse_map_[last_index];
+            key_traits::set_index(slots_[moved_slot_index], value_index);
+            reverse_map_[value_index] = moved_slot_index;
+        }
+        reverse_map_.pop_back();
+
+        detail::release_slot<key_type>(slots_, next_available_slot_index_, slot_index);
+        return 1;
+    }
+
+    bool empty() const
+    {
+        return reverse_map_.empty();
+    }
+    size_type size() const
+    {
+        return reverse_map_.size();
+    }
+    void reserve(size_type n)
+    {
+        hpp::for_each(columns_,
+                      [n](auto& column)
+                      {
+                          column.reserve(n);
+                      });
+        reverse_map_.reserve(n);
+        slots_.reserve(n);
+    }
+
+    // Like slot_map::clear() this also resets every generation counter.
+    void clear()
+    {
+        hpp::for_each(columns_,
+                      [](auto& column)
+                      {
+                          column.clear();
+                      });
+        slots_.clear();
+        reverse_map_.clear();
+        next_available_slot_index_ = key_size_type{};
+    }
+
+    void swap(basic_soa_slot_map& rhs)
+    {
+        using std::swap;
+        swap(columns_, rhs.columns_);
+        swap(slots_, rhs.slots_);
+        swap(reverse_map_, rhs.reverse_map_);
+        swap(next_available_slot_index_, rhs.next_available_slot_index_);
+    }
+
+private:
+    // Appends one field to every column. If a field throws, the fields
+    // appended before it are removed again.
+    template <size_t... I, class... Args>
+    void emplace_columns(std::index_sequence<I...>, Args&&... args)
+    {
+        size_type appended = 0;
+        try
+        {
+            using swallow = int[];
+            (void)swallow{0, (std::get<I>(columns_).emplace_back(std::forward<Args>(args)), ++appended, 0)...};
+        }
+        catch(...)
+        {
+            pop_columns(appended);
+            throw;
+        }
+    }
+
+    // Removes the last row of the first count columns.
+    void pop_columns(size_type count)
+    {
+        size_type column_index = 0;
+        hpp::for_each(columns_,
+                      [&column_index, count](auto& column)
+                      {
+                          if(column_index++ < count)
+                          {
+                              column.pop_back();
+                          }
+                      });
+    }
+
+    std::tuple<std::vector<Ts>...> columns_; // exactly size() entries each
+    std::vector<key_type> slots_;            // high_water_mark() entries
+    std::vector<key_size_type> reverse_map_; // exactly size() entries
+    key_size_type next_available_slot_index_{};
+};
+
+template <class... Ts>
+using soa_slot_map = basic_soa_slot_map<std::pair<unsigned, unsigned>, Ts...>;
+
+} // namespace hpp
@@ -14,8 +14,11 @@
 #include <sstream>
 #include <string>
 #include <type_traits>
+#include <vector>
 
+#include <hpp/detail/cpu_features.hpp>
 #include <hpp/optional.hpp>
+#include <hpp/sha1.hpp>
 #include <hpp/span.hpp>
 #include <hpp/string_view.hpp>
 
@@ -43,12 +46,29 @@
 #include <uuid/uuid.h>
 #endif
 
+#include <pthread.h>
+#define HPP_UUID_HAS_ATFORK
+
 #elif defined(__APPLE__)
 
 #ifdef UUID_SYSTEM_GENERATOR
 #include <CoreFoundation/CFUUID.h>
 #endif
 
+#include <pthread.h>
+#define HPP_UUID_HAS_ATFORK
+
+#endif
+
+// Lets the constexpr parsing functions take the vectorized path at runtime.
+#if defined(__cpp_lib_is_constant_evaluated)
+#define HPP_UUID_IS_CONSTANT_EVALUATED() std::is_constant_evaluated()
+#elif defined(__GNUC__) && __GNUC__ >= 9
+#define HPP_UUID_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#elif defined(__clang__) && __clang_major__ >= 9
+#define HPP_UUID_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#elif defined(_MSC_VER) && _MSC_VER >= 1925
+#define HPP_UUID_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
 #endif
 
 namespace hpp
@@ -91,200 +111,6 @@ to_string_view(StringType const& str) noexcept
 	return str;
 }
 
-class sha1
-{
-public:
-	using digest32_t = uint32_t[5];
-	using digest8_t = uint8_t[20];
-
-	static constexpr unsigned int block_bytes = 64;
-
-	[[nodiscard]] inline static uint32_t left_rotate(uint32_t value, size_t const count) noexcept
-	{
-		return (value << count) ^ (value >> (32 - count));
-	}
-
-	sha1()
-	{
-		reset();
-	}
-
-	void reset() noexcept
-	{
-		m_digest[0] = 0x67452301;
-		m_digest[1] = 0xEFCDAB89;
-		m_digest[2] = 0x98BADCFE;
-		m_digest[3] = 0x10325476;
-		m_digest[4] = 0xC3D2E1F0;
-		m_blockByteIndex = 0;
-		m_byteCount = 0;
-	}
-
-	void process_byte(uint8_t octet)
-	{
-		this->m_block[this->m_blockByteIndex++] = octet;
-		++this->m_byteCount;
-		if(m_blockByteIndex == block_bytes)
-		{
-			this->m_blockByteIndex = 0;
-			process_block();
-		}
-	}
-
-	void process_block(void const* const start, void const* const end)
-	{
-		const uint8_t* begin = static_cast<const uint8_t*>(start);
-		const uint8_t* finish = static_cast<const uint8_t*>(end);
-		while(begin != finish)
-		{
-			process_byte(*begin);
-			begin++;
-		}
-	}
-
-	void process_bytes(void const* const data, size_t const len)
-	{
-		const uint8_t* block = static_cast<const uint8_t*>(data);
-		process_block(block, block + len);
-	}
-
-	uint32_t const* get_digest(digest32_t digest)
-	{
-		size_t const bitCount = this->m_byteCount * 8;
-		process_byte(0x80);
-		if(this->m_blockByteIndex > 56)
-		{
-			while(m_blockByteIndex != 0)
-			{
-				process_byte(0);
-			}
-			while(m_blockByteIndex < 56)
-			{
-				process_byte(0);
-			}
-		}
-		else
-		{
-			while(m_blockByteIndex < 56)
-			{
-				process_byte(0);
-			}
-		}
-		process_byte(0);
-		process_byte(0);
-		process_byte(0);
-		process_byte(0);
-		process_byte(static_cast<unsigned char>((bitCount >> 24) & 0xFF));
-		process_byte(static_cast<unsigned char>((bitCount >> 16) & 0xFF));
-		process_byte(static_cast<unsigned char>((bitCount >> 8) & 0xFF));
-		process_byte(static_cast<unsigned char>((bitCount) & 0xFF));
-
-		memcpy(digest, m_digest, 5 * sizeof(uint32_t));
-		return digest;
-	}
-
-	uint8_t const* get_digest_bytes(digest8_t digest)
-	{
-		digest32_t d32;
-		get_digest(d32);
-		size_t di = 0;
-		digest[di++] = static_cast<uint8_t>(d32[0] >> 24);
-		digest[di++] = static_cast<uint8_t>(d32[0] >> 16);
-		digest[di++] = static_cast<uint8_t>(d32[0] >> 8);
-		digest[di++] = static_cast<uint8_t>(d32[0] >> 0);
-
-		digest[di++] = static_cast<uint8_t>(d32[1] >> 24);
-		digest[di++] = static_cast<uint8_t>(d32[1] >> 16);
-		digest[di++] = static_cast<uint8_t>(d32[1] >> 8);
-		digest[di++] = static_cast<uint8_t>(d32[1] >> 0);
-
-		digest[di++] = static_cast<uint8_t>(d32[2] >> 24);
-		digest[di++] = static_cast<uint8_t>(d32[2] >> 16);
-		digest[di++] = static_cast<uint8_t>(d32[2] >> 8);
-		digest[di++] = static_cast<uint8_t>(d32[2] >> 0);
-
-		digest[di++] = static_cast<uint8_t>(d32[3] >> 24);
-		digest[di++] = static_cast<uint8_t>(d32[3] >> 16);
-		digest[di++] = static_cast<uint8_t>(d32[3] >> 8);
-		digest[di++] = static_cast<uint8_t>(d32[3] >> 0);
-
-		digest[di++] = static_cast<uint8_t>(d32[4] >> 24);
-		digest[di++] = static_cast<uint8_t>(d32[4] >> 16);
-		digest[di++] = static_cast<uint8_t>(d32[4] >> 8);
-		digest[di++] = static_cast<uint8_t>(d32[4] >> 0);
-
-		return digest;
-	}
-
-private:
-	void process_block()
-	{
-		uint32_t w[80];
-		for(size_t i = 0; i < 16; i++)
-		{
-			w[i] = static_cast<uint32_t>(m_block[i * 4 + 0] << 24);
-			w[i] |= static_cast<uint32_t>(m_block[i * 4 + 1] << 16);
-			w[i] |= static_cast<uint32_t>(m_block[i * 4 + 2] << 8);
-			w[i] |= static_cast<uint32_t>(m_block[i * 4 + 3]);
-		}
-		for(size_t i = 16; i < 80; i++)
-		{
-			w[i] = left_rotate((w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16]), 1);
-		}
-
-		uint32_t a = m_digest[0];
-		uint32_t b = m_digest[1];
-		uint32_t c = m_digest[2];
-		uint32_t d = m_digest[3];
-		uint32_t e = m_digest[4];
-
-		for(std::size_t i = 0; i < 80; ++i)
-		{
-			uint32_t f = 0;
-			uint32_t k = 0;
-
-			if(i < 20)
-			{
-				f = (b & c) | (~b & d);
-				k = 0x5A827999;
-			}
-			else if(i < 40)
-			{
-				f = b ^ c ^ d;
-				k = 0x6ED9EBA1;
-			}
-			else if(i < 60)
-			{
-				f = (b & c) | (b & d) | (c & d);
-				k = 0x8F1BBCDC;
-			}
-			else
-			{
-				f = b ^ c ^ d;
-				k = 0xCA62C1D6;
-			}
-			uint32_t temp = left_rotate(a, 5) + f + e + k + w[i];
-			e = d;
-			d = c;
-			c = left_rotate(b, 30);
-			b = a;
-			a = temp;
-		}
-
-		m_digest[0] += a;
-		m_digest[1] += b;
-		m_digest[2] += c;
-		m_digest[3] += d;
-		m_digest[4] += e;
-	}
-
-private:
-	digest32_t m_digest;
-	uint8_t m_block[64];
-	size_t m_blockByteIndex;
-	size_t m_byteCount;
-};
-
 template <typename CharT>
 inline constexpr CharT empty_guid[37] = "00000000-0000-0000-0000-000000000000";
 
@@ -302,6 +128,107 @@ inline constexpr CharT guid_encoder_upper[17] = "0123456789ABCDEF";
 
 template <>
 inline constexpr wchar_t guid_encoder_upper<wchar_t>[17] = L"0123456789ABCDEF";
+
+#ifdef HPP_ARCH_X86
+// Byte order of the first three fields flipped, matching the memcpy based
+// endian swaps of from_string/to_string on little endian hosts.
+HPP_TARGET("ssse3")
+inline __m128i uuid_flip_fields(__m128i bytes) noexcept
+{
+	return _mm_shuffle_epi8(bytes, _mm_setr_epi8(3, 2, 1, 0, 5, 4, 7, 6, 8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+// Converts 16 hex characters to their nibble values. Returns false if any is not a hex digit.
+HPP_TARGET("ssse3")
+inline bool uuid_hex_to_nibbles(__m128i chars, __m128i& nibbles) noexcept
+{
+	const __m128i digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+	const __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+	const __m128i letter = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+	const __m128i is_letter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+
+	nibbles = _mm_or_si128(_mm_and_si128(is_digit, digit),
+						   _mm_and_si128(is_letter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+	return _mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)) == 0xffff;
+}
+
+// Parses a canonical xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx string (exactly 36 chars
+// readable at str) into the byte layout produced by uuid::from_string.
+HPP_TARGET("ssse3")
+inline bool uuid_parse_canonical_ssse3(const char* str, uint8_t* bytes) noexcept
+{
+	if(str[8] != '-' || str[13] != '-' || str[18] != '-' || str[23] != '-')
+		return false;
+
+	const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str));
+	const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + 16));
+	const __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + 20));
+
+	// gather the 32 hex digits, skipping the dashes
+	const __m128i hex0 = _mm_or_si128(
+		_mm_shuffle_epi8(v0, _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 9, 10, 11, 12, 14, 15, -1, -1)),
+		_mm_shuffle_epi8(v1, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 1)));
+	const __m128i hex1 = _mm_or_si128(
+		_mm_shuffle_epi8(v1, _mm_setr_epi8(3, 4, 5, 6, 8, 9, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1)),
+		_mm_shuffle_epi8(v2, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 12, 13, 14, 15)));
+
+	__m128i nibbles0;
+	__m128i nibbles1;
+	const bool valid0 = uuid_hex_to_nibbles(hex0, nibbles0);
+	const bool valid1 = uuid_hex_to_nibbles(hex1, nibbles1);
+	if(!valid0 || !valid1)
+		return false;
+
+	// high nibble * 16 + low nibble for every pair
+	const __m128i weights = _mm_set1_epi16(0x0110);
+	const __m128i packed =
+		_mm_packus_epi16(_mm_maddubs_epi16(nibbles0, weights), _mm_maddubs_epi16(nibbles1, weights));
+
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(bytes), uuid_flip_fields(packed));
+	return true;
+}
+
+// Writes the 36 character canonical form of bytes using the 16 entry encoder table.
+HPP_TARGET("ssse3")
+inline void uuid_format_canonical_ssse3(const uint8_t* bytes, bool flip_fields, const char* encoder,
+										char* out) noexcept
+{
+	__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+	if(flip_fields)
+		v = uuid_flip_fields(v);
+
+	const __m128i table = _mm_loadu_si128(reinterpret_cast<const __m128i*>(encoder));
+	const __m128i mask = _mm_set1_epi8(0x0f);
+	const __m128i hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+	const __m128i lo = _mm_and_si128(v, mask);
+
+	char hex[32];
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(hex), _mm_shuffle_epi8(table, _mm_unpacklo_epi8(hi, lo)));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(hex + 16), _mm_shuffle_epi8(table, _mm_unpackhi_epi8(hi, lo)));
+
+	std::memcpy(out, hex, 8);
+	out[8] = '-';
+	std::memcpy(out + 9, hex + 8, 4);
+	out[13] = '-';
+	std::memcpy(out + 14, hex + 12, 4);
+	out[18] = '-';
+	std::memcpy(out + 19, hex + 16, 4);
+	out[23] = '-';
+	std::memcpy(out + 24, hex + 20, 12);
+}
+#endif
+
+// Runtime only fast path for canonical 36 character strings.
+inline bool uuid_parse_canonical(const char* str, uint8_t* bytes) noexcept
+{
+#ifdef HPP_ARCH_X86
+	if(get_cpu_features().ssse3)
+		return uuid_parse_canonical_ssse3(str, bytes);
+#endif
+	(void)str;
+	(void)bytes;
+	return false;
+}
 } // namespace detail
 
 // --------------------------------------------------------------------------------------------------------------------------
@@ -466,6 +393,18 @@ public:
 		if(str.empty())
 			return false;
 
+#ifdef HPP_UUID_IS_CONSTANT_EVALUATED
+		if constexpr(std::is_same_v<typename decltype(str)::value_type, char>)
+		{
+			uint8_t bytes[16];
+			if(!HPP_UUID_IS_CONSTANT_EVALUATED() && str.size() == 36 &&
+			   detail::uuid_parse_canonical(str.data(), bytes))
+			{
+				return true;
+			}
+		}
+#endif
+
 		if(str.front() == '{')
 			hasBraces = 1;
 		if(hasBraces && str.back() != '}')
@@ -508,6 +447,17 @@ public:
 		bool firstDigit = true;
 		size_t index = 0;
 
+#ifdef HPP_UUID_IS_CONSTANT_EVALUATED
+		if constexpr(std::is_same_v<typename decltype(str)::value_type, char>)
+		{
+			if(!HPP_UUID_IS_CONSTANT_EVALUATED() && str.size() == 36 &&
+			   detail::uuid_parse_canonical(str.data(), raw_data.data()))
+			{
+				return uuid(raw_data);
+			}
+		}
+#endif
+
 		// Parse the string into raw_data
 		for(size_t i = 0; i < str.size(); ++i)
 		{
@@ -574,13 +524,55 @@ public:
 		return to_string_impl<CharT, Traits, Allocator, 17>(detail::guid_encoder_upper<CharT>);
 	}
 
+	// Parses strs[i] into out[i] for min(strs.size(), out.size()) strings.
+	// Invalid strings produce an empty optional, exactly like from_string.
+	template <typename StringType>
+	static void parse_many(span<StringType const> strs, span<optional<uuid>> out) noexcept
+	{
+		const size_t count = strs.size() < out.size() ? strs.size() : out.size();
+		for(size_t i = 0; i < count; ++i)
+			out[i] = from_string(strs[i]);
+	}
+
+	// Writes the 36 character form of every id back to back into out, without
+	// separators or terminators. Stops when out has no room for another id.
+	static void format_many(span<uuid const> ids, span<char> out, bool uppercase = false) noexcept
+	{
+		const size_t count = ids.size() < out.size() / 36 ? ids.size() : out.size() / 36;
+		for(size_t i = 0; i < count; ++i)
+		{
+			if(uppercase)
+				ids[i].to_chars_impl(out.data() + i * 36, detail::guid_encoder_upper<char>);
+			else
+				ids[i].to_chars_impl(out.data() + i * 36, detail::guid_encoder<char>);
+		}
+	}
+
 private:
 	template <class CharT, class Traits, class Allocator, size_t N>
 	[[nodiscard]] inline std::basic_string<CharT, Traits, Allocator>
 	to_string_impl(const CharT (&encoder)[N]) const
 	{
-
 		std::basic_string<CharT, Traits, Allocator> uustr{detail::empty_guid<CharT>};
+		to_chars_impl(&uustr[0], encoder);
+		return uustr;
+	}
+
+	// Writes the 36 characters (dashes included) of the canonical form to uustr.
+	template <class CharT, size_t N>
+	void to_chars_impl(CharT* uustr, const CharT (&encoder)[N]) const noexcept
+	{
+#ifdef HPP_ARCH_X86
+		if constexpr(std::is_same_v<CharT, char>)
+		{
+			if(detail::get_cpu_features().ssse3)
+			{
+				const bool flip_fields = variant() != uuid_variant::microsoft;
+				detail::uuid_format_canonical_ssse3(data.data(), flip_fields, encoder, uustr);
+				return;
+			}
+		}
+#endif
 
 		// Helper functions for swapping endianness
 		auto const swap_endian = [](uint32_t val) -> uint32_t
@@ -649,8 +641,6 @@ private:
 			uustr[index++] = encoder[(data[i] >> 4) & 0x0F];
 			uustr[index++] = encoder[data[i] & 0x0F];
 		}
-
-		return uustr;
 	}
 
 	std::array<value_type, 16> data{{0}};
@@ -704,6 +694,76 @@ inline void swap(hpp::uuid& lhs, hpp::uuid& rhs) noexcept
 	lhs.swap(rhs);
 }
 
+// Hash for uuid keys, the one std::hash<uuid> uses. The 16 bytes are read as
+// two unaligned 64 bit words and combined as a ^ rotl(b * k, 32), which stays
+// non-zero for equal, swapped or zero halves, then run through the murmur3
+// fmix64 finalizer so every input bit reaches every output bit. Sequential
+// and name based uuids spread over the buckets like random ones.
+//
+// It is transparent: strings hash like the uuid they parse to, so with
+// uuid_equal an unordered container keyed by uuid can be searched with a
+// string_view without building a uuid first (C++20 heterogeneous lookup).
+struct uuid_hash
+{
+	using is_transparent = void;
+
+	[[nodiscard]] size_t operator()(uuid const& id) const noexcept
+	{
+		uint64_t a;
+		uint64_t b;
+		auto const data = id.as_bytes();
+		std::memcpy(&a, data.data(), sizeof(a));
+		std::memcpy(&b, data.data() + sizeof(a), sizeof(b));
+
+		// the odd multiplier and the rotation are both bijective, so only
+		// a == rotl(b * k, 32) gives zero and no simple pattern does
+		b *= 0x9e3779b97f4a7c15ull;
+		uint64_t x = a ^ ((b << 32) | (b >> 32));
+
+		x ^= x >> 33;
+		x *= 0xff51afd7ed558ccdull;
+		x ^= x >> 33;
+		x *= 0xc4ceb9fe1a85ec53ull;
+		x ^= x >> 33;
+
+		if constexpr(sizeof(size_t) >= sizeof(uint64_t))
+		{
+			return static_cast<size_t>(x);
+		}
+		else
+		{
+			return static_cast<size_t>(uint32_t(x >> 32) ^ uint32_t(x));
+		}
+	}
+
+	// Strings that are not valid uuids all hash like the nil uuid.
+	[[nodiscard]] size_t operator()(string_view str) const noexcept
+	{
+		return (*this)(uuid::from_string(str).value_or(uuid{}));
+	}
+};
+
+// Equality companion of uuid_hash. A string compares equal to a uuid only if
+// it parses to that uuid.
+struct uuid_equal
+{
+	using is_transparent = void;
+
+	[[nodiscard]] bool operator()(uuid const& lhs, uuid const& rhs) const noexcept
+	{
+		return lhs == rhs;
+	}
+	[[nodiscard]] bool operator()(uuid const& lhs, string_view rhs) const noexcept
+	{
+		auto parsed = uuid::from_string(rhs);
+		return parsed && *parsed == lhs;
+	}
+	[[nodiscard]] bool operator()(string_view lhs, uuid const& rhs) const noexcept
+	{
+		return (*this)(rhs, lhs);
+	}
+};
+
 // --------------------------------------------------------------------------------------------------------------------------
 // namespace IDs that could be used for generating name-based hpp
 // --------------------------------------------------------------------------------------------------------------------------
@@ -828,51 +888,288 @@ private:
 
 using uuid_random_generator = basic_uuid_random_generator<std::mt19937>;
 
+namespace detail
+{
+// xoshiro256** (Blackman/Vigna). 256 bits of state, period 2^256 - 1, passes
+// BigCrush. Satisfies UniformRandomBitGenerator so it can also drive
+// basic_uuid_random_generator.
+class xoshiro256ss
+{
+public:
+	using result_type = uint64_t;
+
+	explicit xoshiro256ss(uint64_t seed) noexcept
+	{
+		// splitmix64 expands the seed so that similar seeds give unrelated states
+		for(auto& word : state)
+		{
+			seed += 0x9e3779b97f4a7c15ull;
+			uint64_t z = seed;
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+			word = z ^ (z >> 31);
+		}
+	}
+
+	// Takes the whole state from the device.
+	explicit xoshiro256ss(std::random_device& device)
+		: xoshiro256ss(0)
+	{
+		uint64_t mixed = 0;
+		for(auto& word : state)
+		{
+			word ^= (uint64_t(device()) << 32) | device();
+			mixed |= word;
+		}
+		// the all zero state is the one fixed point
+		if(mixed == 0)
+			state[0] = 1;
+	}
+
+	[[nodiscard]] static constexpr result_type min() noexcept
+	{
+		return 0;
+	}
+	[[nodiscard]] static constexpr result_type max() noexcept
+	{
+		return ~result_type(0);
+	}
+
+	result_type operator()() noexcept
+	{
+		const uint64_t result = rotl(state[1] * 5, 7) * 9;
+		const uint64_t t = state[1] << 17;
+
+		state[2] ^= state[0];
+		state[3] ^= state[1];
+		state[1] ^= state[2];
+		state[0] ^= state[3];
+		state[2] ^= t;
+		state[3] = rotl(state[3], 45);
+
+		return result;
+	}
+
+private:
+	static constexpr uint64_t rotl(uint64_t x, int k) noexcept
+	{
+		return (x << k) | (x >> (64 - k));
+	}
+
+	uint64_t state[4];
+};
+
+// Counts the fork() calls made by this process and its ancestors since the
+// first call, as seen from the child. Per-thread engines compare it with the
+// value they were seeded at, so a child does not repeat its parent's stream.
+inline uint32_t uuid_fork_generation() noexcept
+{
+	static std::atomic<uint32_t> generation{0};
+#ifdef HPP_UUID_HAS_ATFORK
+	static const bool registered = []()
+	{
+		pthread_atfork(nullptr, nullptr, []() { generation.fetch_add(1, std::memory_order_relaxed); });
+		return true;
+	}();
+	(void)registered;
+#endif
+	return generation.load(std::memory_order_relaxed);
+}
+} // namespace detail
+
+// Version 4 uuid generator backed by a per-thread xoshiro256** engine.
+// The engine is created on first use in each thread and seeded with 256 bits
+// from std::random_device, so instances are stateless and can be shared or
+// used from any number of threads without locking.
+//
+// Every uuid carries 122 random bits. With n uuids generated the chance of any
+// collision is about n^2 / 2^123 (roughly 1e-15 for n = 1e11), as long as
+// std::random_device is a real entropy source. Threads never share a stream,
+// and after fork() the child reseeds its engines instead of repeating the
+// parent's uuids. The output is predictable from earlier output, so do not use it for
+// security tokens.
+class uuid_fast_random_generator
+{
+public:
+	[[nodiscard]] uuid operator()()
+	{
+		return make_uuid(engine());
+	}
+
+	// Fills every element of out with a new uuid.
+	void fill(span<uuid> out)
+	{
+		auto& gen = engine();
+		for(auto& id : out)
+			id = make_uuid(gen);
+	}
+
+private:
+	static detail::xoshiro256ss& engine()
+	{
+		thread_local uint32_t seeded_at = detail::uuid_fork_generation();
+		thread_local detail::xoshiro256ss gen = make_engine();
+
+		const uint32_t generation = detail::uuid_fork_generation();
+		if(generation != seeded_at)
+		{
+			seeded_at = generation;
+			gen = make_engine();
+		}
+		return gen;
+	}
+
+	static detail::xoshiro256ss make_engine()
+	{
+		std::random_device device;
+		return detail::xoshiro256ss(device);
+	}
+
+	static uuid make_uuid(detail::xoshiro256ss& gen) noexcept
+	{
+		const uint64_t words[2] = {gen(), gen()};
+		std::array<uint8_t, 16> bytes;
+		std::memcpy(bytes.data(), words, sizeof(words));
+
+		// variant must be 10xxxxxx
+		bytes[8] &= 0xBF;
+		bytes[8] |= 0x80;
+
+		// version must be 0100xxxx
+		bytes[6] &= 0x4F;
+		bytes[6] |= 0x40;
+
+		return uuid{bytes};
+	}
+};
+
 class uuid_name_generator
 {
 public:
 	explicit uuid_name_generator(uuid const& namespace_uuid) noexcept
 		: nsuuid(namespace_uuid)
 	{
+		auto nsbytes = nsuuid.as_bytes();
+		ns_hasher.add(nsbytes.data(), nsbytes.size());
 	}
 
 	template <typename StringType>
 	[[nodiscard]] uuid operator()(StringType const& name)
 	{
-		reset();
-		process_characters(detail::to_string_view(name));
-		return make_uuid();
+		// resume from the state right after the namespace bytes
+		sha1 hasher = ns_hasher;
+		process_characters(hasher, detail::to_string_view(name));
+		hasher.finalize();
+		return make_uuid(hasher.state);
 	}
 
-private:
-	void reset()
+	// Generates out[i] = (*this)(names[i]) for min(names.size(), out.size()) names.
+	// Groups of names are laid out back to back and hashed several at a time with sha1_batch.
+	template <typename StringType>
+	void generate_batch(span<StringType const> names, span<uuid> out)
 	{
-		hasher.reset();
-		std::byte bytes[16];
+		constexpr size_t group_size = 64;
+
+		const size_t count = names.size() < out.size() ? names.size() : out.size();
 		auto nsbytes = nsuuid.as_bytes();
-		std::copy(std::cbegin(nsbytes), std::cend(nsbytes), bytes);
-		hasher.process_bytes(bytes, 16);
+
+		std::vector<uint8_t> buffer;
+		size_t offsets[group_size + 1]{};
+		span<const uint8_t> messages[group_size];
+		sha1_digest digests[group_size];
+
+		for(size_t first = 0; first < count; first += group_size)
+		{
+			const size_t n = count - first < group_size ? count - first : group_size;
+			for(size_t i = 0; i < n; ++i)
+				offsets[i + 1] = offsets[i] + 16 + encoded_size(detail::to_string_view(names[first + i]));
+
+			buffer.resize(offsets[n]);
+			for(size_t i = 0; i < n; ++i)
+			{
+				uint8_t* dst = buffer.data() + offsets[i];
+				std::memcpy(dst, nsbytes.data(), 16);
+				encode_characters(dst + 16, detail::to_string_view(names[first + i]));
+				messages[i] = span<const uint8_t>(dst, offsets[i + 1] - offsets[i]);
+			}
+
+			sha1_batch(span<const span<const uint8_t>>(messages, n), span<sha1_digest>(digests, n));
+			for(size_t i = 0; i < n; ++i)
+				out[first + i] = make_uuid(digests[i]);
+		}
 	}
 
+	template <typename StringType>
+	[[nodiscard]] std::vector<uuid> generate_batch(span<StringType const> names)
+	{
+		std::vector<uuid> result(names.size());
+		generate_batch(names, span<uuid>(result));
+		return result;
+	}
+
+private:
+	// Characters wider than char are hashed as 4 little endian bytes.
+	template <typename CharT>
+	static constexpr size_t bytes_per_char = std::is_same_v<CharT, char> ? 1 : 4;
+
 	template <typename CharT, typename Traits>
-	void process_characters(basic_string_view<CharT, Traits> const str)
+	[[nodiscard]] static size_t encoded_size(basic_string_view<CharT, Traits> const str) noexcept
 	{
-		for(uint32_t c : str)
+		return str.size() * bytes_per_char<CharT>;
+	}
+
+	template <typename CharT, typename Traits>
+	static void encode_characters(uint8_t* dst, basic_string_view<CharT, Traits> const str) noexcept
+	{
+		if constexpr(std::is_same_v<CharT, char>)
+		{
+			if(!str.empty())
+				std::memcpy(dst, str.data(), str.size());
+		}
+		else
 		{
-			hasher.process_byte(static_cast<uint8_t>(c & 0xFF));
-			if constexpr(!std::is_same_v<CharT, char>)
+			for(uint32_t c : str)
 			{
-				hasher.process_byte(static_cast<uint8_t>((c >> 8) & 0xFF));
-				hasher.process_byte(static_cast<uint8_t>((c >> 16) & 0xFF));
-				hasher.process_byte(static_cast<uint8_t>((c >> 24) & 0xFF));
+				*dst++ = static_cast<uint8_t>(c & 0xFF);
+				*dst++ = static_cast<uint8_t>((c >> 8) & 0xFF);
+				*dst++ = static_cast<uint8_t>((c >> 16) & 0xFF);
+				*dst++ = static_cast<uint8_t>((c >> 24) & 0xFF);
 			}
 		}
 	}
 
-	[[nodiscard]] uuid make_uuid()
+	template <typename CharT, typename Traits>
+	static void process_characters(sha1& hasher, basic_string_view<CharT, Traits> const str)
 	{
-		detail::sha1::digest8_t digest;
-		hasher.get_digest_bytes(digest);
+		if constexpr(std::is_same_v<CharT, char>)
+		{
+			hasher.add(str.data(), str.size());
+		}
+		else
+		{
+			// encode in chunks so the hasher still sees whole blocks
+			constexpr size_t chars_per_chunk = 64;
+			uint8_t chunk[chars_per_chunk * 4];
+			for(size_t pos = 0; pos < str.size(); pos += chars_per_chunk)
+			{
+				const size_t n = str.size() - pos < chars_per_chunk ? str.size() - pos : chars_per_chunk;
+				encode_characters(chunk, str.substr(pos, n));
+				hasher.add(chunk, n * 4);
+			}
+		}
+	}
+
+	template <typename Digest>
+	[[nodiscard]] static uuid make_uuid(Digest const& state)
+	{
+		uint8_t digest[16];
+		for(size_t i = 0; i < 4; ++i)
+		{
+			digest[i * 4 + 0] = static_cast<uint8_t>(state[i] >> 24);
+			digest[i * 4 + 1] = static_cast<uint8_t>(state[i] >> 16);
+			digest[i * 4 + 2] = static_cast<uint8_t>(state[i] >> 8);
+			digest[i * 4 + 3] = static_cast<uint8_t>(state[i] >> 0);
+		}
 
 		// variant must be 0b10xxxxxx
 		digest[8] &= 0xBF;
@@ -887,7 +1184,7 @@ private:
 
 private:
 	uuid nsuuid;
-	detail::sha1 hasher;
+	sha1 ns_hasher;
 };
 
 #ifdef UUID_TIME_GENERATOR
@@ -992,24 +1289,7 @@ struct hash<hpp::uuid>
 		std::hash<std::string> hasher;
 		return static_cast<result_type>(hasher(hpp::to_string(uuid)));
 #else
-		uint64_t l = static_cast<uint64_t>(uuid.data[0]) << 56 | static_cast<uint64_t>(uuid.data[1]) << 48 |
-					 static_cast<uint64_t>(uuid.data[2]) << 40 | static_cast<uint64_t>(uuid.data[3]) << 32 |
-					 static_cast<uint64_t>(uuid.data[4]) << 24 | static_cast<uint64_t>(uuid.data[5]) << 16 |
-					 static_cast<uint64_t>(uuid.data[6]) << 8 | static_cast<uint64_t>(uuid.data[7]);
-		uint64_t h = static_cast<uint64_t>(uuid.data[8]) << 56 | static_cast<uint64_t>(uuid.data[9]) << 48 |
-					 static_cast<uint64_t>(uuid.data[10]) << 40 | static_cast<uint64_t>(uuid.data[11]) << 32 |
-					 static_cast<uint64_t>(uuid.data[12]) << 24 | static_cast<uint64_t>(uuid.data[13]) << 16 |
-					 static_cast<uint64_t>(uuid.data[14]) << 8 | static_cast<uint64_t>(uuid.data[15]);
-
-		if constexpr(sizeof(result_type) > 4)
-		{
-			return result_type(l ^ h);
-		}
-		else
-		{
-			uint64_t hash64 = l ^ h;
-			return result_type(uint32_t(hash64 >> 32) ^ uint32_t(hash64));
-		}
+		return hpp::uuid_hash{}(uuid);
 #endif
 	}
 };
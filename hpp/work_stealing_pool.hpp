@@ -0,0 +1,303 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace hpp
+{
+
+// A small fork/join pool for data parallel loops.
+//
+// parallel_for(count, grain, body) cuts [0, count) into chunks of grain
+// elements (the last one may be shorter) and calls body(begin, end) once per
+// chunk. The chunk boundaries only depend on count and grain, never on the
+// number of threads or on timing.
+//
+// Every participant starts with a contiguous run of chunks and takes them
+// from the front. A participant whose run is empty steals single chunks
+// from the back of the other runs. The calling thread participates too, so
+// a pool with N worker threads runs loops on N + 1 threads.
+//
+// Only one loop runs at a time. A parallel_for called from inside a body,
+// or while another thread's loop is running, runs inline on the caller.
+// The first exception thrown by a body is rethrown from parallel_for once
+// all chunks are done; chunks not yet started are skipped.
+class work_stealing_pool
+{
+public:
+    static size_t default_thread_count()
+    {
+        const auto hardware = std::thread::hardware_concurrency();
+        return hardware > 1 ? hardware - 1 : 0;
+    }
+
+    // The process wide pool with default_thread_count() workers.
+    static work_stealing_pool& shared()
+    {
+        static work_stealing_pool pool;
+        return pool;
+    }
+
+    explicit work_stealing_pool(size_t thread_count = default_thread_count())
+    {
+        workers_.reserve(thread_count);
+        for(size_t i = 0; i < thread_count; ++i)
+        {
+            workers_.emplace_back(
+                [this, i]()
+                {
+                    worker_loop(i);
+                });
+        }
+    }
+
+    work_stealing_pool(const work_stealing_pool&) = delete;
+    work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+
+    ~work_stealing_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for(auto& worker : workers_)
+        {
+            worker.join();
+        }
+    }
+
+    // Number of threads a loop runs on, including the caller.
+    size_t concurrency() const
+    {
+        return workers_.size() + 1;
+    }
+
+    template <class Body>
+    void parallel_for(size_t count, size_t grain, Body&& body)
+    {
+        grain = (std::max)(grain, size_t(1));
+        const auto chunk_count = (count + grain - 1) / grain;
+
+        std::unique_lock<std::mutex> run_lock(run_mutex_, std::try_to_lock);
+        if(!run_lock.owns_lock() || in_worker() || workers_.empty() || chunk_count <= 1 ||
+           chunk_count > 0xffffffffu)
+        {
+            for(size_t begin = 0; begin < count; begin += grain)
+            {
+                body(begin, (std::min)(count, begin + grain));
+            }
+            return;
+        }
+
+        job task;
+        task.count = count;
+        task.grain = grain;
+        task.body = &body;
+        task.call = [](void* b, size_t begin, size_t end)
+        {
+            (*static_cast<typename std::remove_reference<Body>::type*>(b))(begin, end);
+        };
+        task.remaining.store(chunk_count, std::memory_order_relaxed);
+
+        // initial contiguous runs, one per participant
+        const auto participants = concurrency();
+        task.runs.reset(new std::atomic<uint64_t>[participants]);
+        for(size_t i = 0; i < participants; ++i)
+        {
+            const auto first = chunk_count * i / participants;
+            const auto last = chunk_count * (i + 1) / participants;
+            task.runs[i].store(pack(first, last), std::memory_order_relaxed);
+        }
+        task.participants = participants;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            current_ = &task;
+            ++generation_;
+        }
+        wake_.notify_all();
+
+        execute(task, participants - 1);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock,
+                   [&task]()
+                   {
+                       return task.remaining.load(std::memory_order_acquire) == 0;
+                   });
+        // no worker can pick the job up anymore, wait for those still in it
+        current_ = nullptr;
+        done_.wait(lock,
+                   [&task]()
+                   {
+                       return task.active == 0;
+                   });
+        lock.unlock();
+
+        if(task.error)
+        {
+            std::rethrow_exception(task.error);
+        }
+    }
+
+private:
+    struct job
+    {
+        size_t count{};
+        size_t grain{};
+        void* body{};
+        void (*call)(void*, size_t, size_t){};
+
+        // [first, last) chunk indices per participant, packed as first << 32 | last
+        std::unique_ptr<std::atomic<uint64_t>[]> runs;
+        size_t participants{};
+
+        std::atomic<size_t> remaining{};
+        std::atomic<bool> failed{false};
+        std::exception_ptr error;
+        size_t active{}; // workers inside execute(), guarded by mutex_
+    };
+
+    static uint64_t pack(uint64_t first, uint64_t last)
+    {
+        return (first << 32) | last;
+    }
+
+    static bool pop_front(std::atomic<uint64_t>& run, size_t& chunk)
+    {
+        auto current = run.load(std::memory_order_relaxed);
+        for(;;)
+        {
+            const auto first = current >> 32;
+            const auto last = current & 0xffffffffu;
+            if(first >= last)
+            {
+                return false;
+            }
+            if(run.compare_exchange_weak(current, pack(first + 1, last), std::memory_order_relaxed))
+            {
+                chunk = size_t(first);
+                return true;
+            }
+        }
+    }
+
+    static bool pop_back(std::atomic<uint64_t>& run, size_t& chunk)
+    {
+        auto current = run.load(std::memory_order_relaxed);
+        for(;;)
+        {
+            const auto first = current >> 32;
+            const auto last = current & 0xffffffffu;
+            if(first >= last)
+            {
+                return false;
+            }
+            if(run.compare_exchange_weak(current, pack(first, last - 1), std::memory_order_relaxed))
+            {
+                chunk = size_t(last - 1);
+                return true;
+            }
+        }
+    }
+
+    static bool& in_worker()
+    {
+        thread_local bool value = false;
+        return value;
+    }
+
+    void execute(job& task, size_t self)
+    {
+        for(;;)
+        {
+            size_t chunk{};
+            bool found = pop_front(task.runs[self], chunk);
+            for(size_t i = 1; !found && i < task.participants; ++i)
+            {
+                found = pop_back(task.runs[(self + i) % task.participants], chunk);
+            }
+            if(!found)
+            {
+                return;
+            }
+
+            if(!task.failed.load(std::memory_order_relaxed))
+            {
+                const auto begin = chunk * task.grain;
+                const auto end = (std::min)(task.count, begin + task.grain);
+                try
+                {
+                    task.call(task.body, begin, end);
+                }
+                catch(...)
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if(!task.error)
+                    {
+                        task.error = std::current_exception();
+                    }
+                    task.failed = true;
+                }
+            }
+
+            if(task.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                done_.notify_all();
+            }
+        }
+    }
+
+    void worker_loop(size_t self)
+    {
+        in_worker() = true;
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex_);
+        for(;;)
+        {
+            wake_.wait(lock,
+                       [&]()
+                       {
+                           return stop_ || (generation_ != seen && current_ != nullptr);
+                       });
+            if(stop_)
+            {
+                return;
+            }
+            seen = generation_;
+            auto task = current_;
+            ++task->active;
+            lock.unlock();
+
+            execute(*task, self);
+
+            lock.lock();
+            if(--task->active == 0)
+            {
+                done_.notify_all();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::mutex run_mutex_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    job* current_{};
+    uint64_t generation_{};
+    bool stop_{};
+};
+
+} // namespace hpp
@@ -2,8 +2,49 @@
 #include <hpp/utility.hpp>
 #include <hpp/type_name.hpp>
 #include <hpp/type_index.hpp>
+#include <hpp/crc.hpp>
+#include <hpp/concurrent_slot_map.hpp>
+#include <hpp/crc_parallel.hpp>
+#include <hpp/sha1.hpp>
+#include <hpp/uuid.hpp>
+#include <hpp/slot_map.hpp>
+#include <hpp/chunked_vector.hpp>
+#include <hpp/soa_slot_map.hpp>
+#include <hpp/slot_map_parallel.hpp>
+#include <hpp/slot_map_stream.hpp>
+#include <hpp/generational_arena.hpp>
+#include <hpp/event.hpp>
+#include <hpp/concurrent_event.hpp>
+#include <hpp/queued_event.hpp>
+#include <hpp/event_bus.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#ifdef HPP_UUID_HAS_ATFORK
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#define TEST_CHECK(expr)                                                                                    \
+	if(!(expr))                                                                                             \
+	{                                                                                                       \
+		std::cout << __func__ << ": check failed: " #expr " (line " << __LINE__ << ")" << std::endl;        \
+		return false;                                                                                       \
+	}
 
 namespace test
 {
@@ -22,6 +63,1321 @@ struct my_struct2
 };
 }
 
+bool test_concurrent_slot_map()
+{
+	hpp::concurrent_slot_map<int> map(8192);
+	auto a = map.insert(1);
+	auto b = map.emplace(2);
+	TEST_CHECK(map.size() == 2);
+	TEST_CHECK(map.find(a) == 1 && map.find(b) == 2);
+	TEST_CHECK(map.store(a, 10) && map.find(a) == 10);
+	TEST_CHECK(map.erase(a) == 1 && map.erase(a) == 0);
+	TEST_CHECK(!map.contains(a) && !map.find(a) && !map.store(a, 3));
+	auto c = map.insert(3);
+	TEST_CHECK(c != a && !map.contains(a) && map.find(c) == 3);
+
+	// an 8 bit generation is exhausted after 127 reuses, the slot is retired
+	// instead of handing out keys that wrap around
+	hpp::concurrent_slot_map<int, std::pair<unsigned, unsigned char>> small(4096);
+	for(int i = 0; i < 300; ++i)
+	{
+		auto key = small.insert(i);
+		TEST_CHECK(small.find(key) == i);
+		TEST_CHECK(small.erase(key) == 1);
+		TEST_CHECK(!small.contains(key));
+	}
+	TEST_CHECK(small.empty());
+
+	// another thread takes the free list of this thread's shard, also once
+	// there are no fresh slots left
+	hpp::concurrent_slot_map<int> full(4096);
+	std::vector<std::pair<unsigned, unsigned>> keys;
+	for(int i = 0; i < 4096; ++i)
+	{
+		keys.push_back(full.insert(i));
+	}
+	for(auto key : keys)
+	{
+		full.erase(key);
+	}
+	size_t stolen = 0;
+	std::thread(
+		[&full, &stolen]()
+		{
+			for(int i = 0; i < 4096; ++i)
+			{
+				full.insert(i);
+				stolen++;
+			}
+		})
+		.join();
+	TEST_CHECK(stolen == 4096 && full.size() == 4096);
+
+	// a thread that only inserts reuses the slots other threads erased
+	// instead of taking fresh ones
+	hpp::concurrent_slot_map<int> reused(1 << 20);
+	std::vector<std::pair<unsigned, unsigned>> erased;
+	for(int i = 0; i < 1000; ++i)
+	{
+		erased.push_back(reused.insert(i));
+	}
+	for(auto key : erased)
+	{
+		reused.erase(key);
+	}
+	unsigned highest_index = 0;
+	std::thread(
+		[&reused, &highest_index]()
+		{
+			for(int i = 0; i < 1000; ++i)
+			{
+				highest_index = (std::max)(highest_index, reused.insert(i).first);
+			}
+		})
+		.join();
+	TEST_CHECK(highest_index < 1024);
+
+	// packed keys, a 12 bit generation retires the slot after 2047 reuses
+	hpp::concurrent_slot_map<int, hpp::packed_key32> packed(4096);
+	std::set<uint32_t> packed_values;
+	std::vector<hpp::packed_key32> packed_keys;
+	for(int i = 0; i < 5000; ++i)
+	{
+		auto key = packed.insert(i);
+		TEST_CHECK(packed.find(key) == i && packed_values.insert(key.value()).second);
+		packed_keys.push_back(key);
+		TEST_CHECK(packed.erase(key) == 1);
+	}
+	for(auto key : packed_keys)
+	{
+		TEST_CHECK(!packed.contains(key));
+	}
+	TEST_CHECK(packed_keys.back().index() > 0 && packed.max_slots() == 4096);
+	hpp::concurrent_slot_map<int, hpp::packed_key64> packed64;
+	auto key64 = packed64.insert(64);
+	TEST_CHECK(packed64.find(key64) == 64 && packed64.erase(key64) == 1 && !packed64.contains(key64));
+
+	// threads fill and drain their shards and steal from each other
+	hpp::concurrent_slot_map<int> shared(4096);
+	std::vector<std::thread> threads;
+	bool ok[4]{};
+	for(int t = 0; t < 4; ++t)
+	{
+		threads.emplace_back(
+			[&shared, &ok, t]()
+			{
+				ok[t] = true;
+				std::vector<std::pair<unsigned, unsigned>> own_keys;
+				for(int round = 0; round < 200; ++round)
+				{
+					for(int i = 0; i < 800; ++i)
+					{
+						own_keys.push_back(shared.insert(t * 1000 + i));
+					}
+					for(size_t i = 0; i < own_keys.size(); ++i)
+					{
+						ok[t] = ok[t] && shared.find(own_keys[i]) == int(t * 1000 + i);
+						ok[t] = ok[t] && shared.erase(own_keys[i]) == 1;
+					}
+					own_keys.clear();
+				}
+			});
+	}
+	for(auto& thread : threads)
+	{
+		thread.join();
+	}
+	for(bool thread_ok : ok)
+	{
+		TEST_CHECK(thread_ok);
+	}
+	TEST_CHECK(shared.empty());
+	return true;
+}
+
+// Deterministic bytes for the crc tests.
+std::vector<char> make_crc_data(size_t size)
+{
+	std::vector<char> data(size);
+	for(size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = static_cast<char>(i * 131 + (i >> 9));
+	}
+	return data;
+}
+
+bool test_crc64_fast()
+{
+	// every length through several 64 byte folding blocks, at every
+	// alignment of the start, against the bytewise hash_impl. The buffer
+	// has room for the longest length at the last offset.
+	std::vector<char> data(4096 + 64 + 8);
+	uint64_t state = 0x9e3779b97f4a7c15ull;
+	for(auto& byte : data)
+	{
+		state = state * 6364136223846793005ull + 1442695040888963407ull;
+		byte = static_cast<char>(state >> 56);
+	}
+
+#ifdef HPP_ARCH_X86
+	const auto& features = hpp::detail::get_cpu_features();
+	const bool has_clmul = features.pclmul && features.sse41;
+#endif
+	auto check = [&](const char* input, size_t size, uint64_t seed) {
+		const auto expected = hpp::hash_impl(input, size, seed);
+		if(hpp::detail::hash_impl_slice8(input, size, seed) != expected ||
+		   hpp::hash_impl_fast(input, size, seed) != expected)
+		{
+			return false;
+		}
+#ifdef HPP_ARCH_X86
+		if(has_clmul && hpp::detail::hash_impl_clmul(input, size, seed) != expected)
+		{
+			return false;
+		}
+#endif
+		return true;
+	};
+
+	for(uint64_t seed : {uint64_t(0), ~uint64_t(0), uint64_t(0x0123456789abcdefull)})
+	{
+		for(size_t offset = 0; offset < 8; ++offset)
+		{
+			for(size_t size = 0; size <= 320; ++size)
+			{
+				TEST_CHECK(check(data.data() + offset, size, seed));
+			}
+			for(size_t size : {size_t(1031), size_t(4096), size_t(4096 + 63)})
+			{
+				TEST_CHECK(check(data.data() + offset, size, seed));
+			}
+		}
+	}
+	TEST_CHECK(hpp::crc64_fast(data.data(), 1031) == hpp::crc64(data.data(), 1031));
+	return true;
+}
+
+bool test_crc64_hasher()
+{
+	const auto data = make_crc_data(100003);
+	const auto expected = hpp::crc64(data.data(), data.size());
+
+	for(size_t split : {size_t(0), size_t(1), size_t(4096), data.size() / 3, data.size()})
+	{
+		const auto crc_a = hpp::crc64(data.data(), split);
+		const auto crc_b = hpp::crc64(data.data() + split, data.size() - split);
+		TEST_CHECK(hpp::crc64_combine(crc_a, crc_b, data.size() - split) == expected);
+	}
+
+	hpp::crc64_hasher chunked;
+	for(size_t offset = 0; offset < data.size(); offset += 7919)
+	{
+		chunked.update(data.data() + offset, (std::min)(size_t(7919), data.size() - offset));
+	}
+	TEST_CHECK(chunked.finalize() == expected);
+
+	hpp::crc64_hasher head;
+	hpp::crc64_hasher tail;
+	head.update(hpp::span<const char>(data.data(), 1000));
+	tail.update(data.data() + 1000, data.size() - 1000);
+	TEST_CHECK(head.append(tail).finalize() == expected);
+	TEST_CHECK(hpp::crc64_hasher().finalize() == hpp::crc64("", 0));
+	return true;
+}
+
+bool test_crc64_parallel()
+{
+	const auto data = make_crc_data(3 * hpp::detail::crc64_min_parallel_block + 17);
+	const auto expected = hpp::crc64(data.data(), data.size());
+	for(size_t threads : {size_t(0), size_t(1), size_t(2), size_t(4), size_t(7)})
+	{
+		TEST_CHECK(hpp::crc64_parallel(data.data(), data.size(), threads) == expected);
+	}
+	TEST_CHECK(hpp::crc64_parallel(data.data(), 100, 4) == hpp::crc64(data.data(), 100));
+	TEST_CHECK(hpp::crc64_parallel(data.data(), 0, 4) == hpp::crc64("", 0));
+
+	const std::string path = "hpp_test_crc64_parallel.bin";
+	{
+		std::ofstream file(path, std::ios::binary);
+		file.write(data.data(), std::streamsize(data.size()));
+	}
+	const auto file_crc = hpp::crc64_parallel_file(path, 3);
+	std::remove(path.c_str());
+	TEST_CHECK(file_crc && *file_crc == expected);
+	TEST_CHECK(!hpp::crc64_parallel_file("hpp_test_no_such_file.bin"));
+
+	// a throwing worker is joined with the others and its exception rethrown
+	bool thrown = false;
+	try
+	{
+		hpp::detail::crc64_parallel_blocks(4096, 4, [](size_t offset, size_t) -> uint64_t {
+			if(offset != 0)
+			{
+				throw std::runtime_error("block");
+			}
+			return 0;
+		});
+	}
+	catch(const std::runtime_error&)
+	{
+		thrown = true;
+	}
+	TEST_CHECK(thrown);
+	return true;
+}
+
+bool test_sha1_batch()
+{
+	// every block count and padding case, in batches wide enough for every
+	// lane kernel
+	std::vector<uint8_t> bytes(300);
+	for(size_t i = 0; i < bytes.size(); ++i)
+	{
+		bytes[i] = static_cast<uint8_t>(i * 37 + 11);
+	}
+	std::vector<hpp::span<const uint8_t>> messages;
+	for(size_t size = 0; size < 150; ++size)
+	{
+		messages.emplace_back(bytes.data() + size, size);
+	}
+	std::vector<hpp::sha1_digest> scalar(messages.size());
+	hpp::detail::sha1_batch_scalar(messages.data(), messages.size(), scalar.data());
+
+	std::vector<hpp::sha1_digest> batch(messages.size());
+	hpp::sha1_batch(messages, batch);
+	TEST_CHECK(batch == scalar);
+
+	// fewer digests than messages only hashes as many as fit
+	std::vector<hpp::sha1_digest> few(3);
+	hpp::sha1_batch(messages, few);
+	TEST_CHECK(std::equal(few.begin(), few.end(), scalar.begin()));
+
+#ifdef HPP_SHA1_MULTI_BUFFER
+	const auto& features = hpp::detail::get_cpu_features();
+	std::vector<hpp::sha1_digest> lanes(messages.size());
+	hpp::detail::sha1_batch_sse2(messages.data(), messages.size(), lanes.data());
+	TEST_CHECK(lanes == scalar);
+	if(features.avx2)
+	{
+		hpp::detail::sha1_batch_avx2(messages.data(), messages.size(), lanes.data());
+		TEST_CHECK(lanes == scalar);
+	}
+	if(features.avx512f)
+	{
+		hpp::detail::sha1_batch_avx512(messages.data(), messages.size(), lanes.data());
+		TEST_CHECK(lanes == scalar);
+	}
+#endif
+	return true;
+}
+
+bool test_sha1_known_vectors()
+{
+	// FIPS 180 vectors, hashed on the SHA extensions when the cpu has them
+	const hpp::sha1_digest abc{{0xa9993e36, 0x4706816a, 0xba3e2571, 0x7850c26c, 0x9cd0d89d}};
+	const hpp::sha1_digest empty{{0xda39a3ee, 0x5e6b4b0d, 0x3255bfef, 0x95601890, 0xafd80709}};
+	const hpp::sha1_digest two_blocks{{0x84983e44, 0x1c3bd26e, 0xbaae4aa1, 0xf95129e5, 0xe54670f1}};
+	const hpp::sha1_digest million_a{{0x34aa973c, 0xd4c4daa4, 0xf61eeb2b, 0xdbad2731, 0x6534016f}};
+
+	TEST_CHECK(hpp::sha1::hash_once("abc", 3) == abc);
+	TEST_CHECK(hpp::sha1::hash_once("", 0) == empty);
+	const char* text = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+	TEST_CHECK(hpp::sha1::hash_once(text, std::strlen(text)) == two_blocks);
+	std::vector<uint8_t> a(1000000, 'a');
+	TEST_CHECK(hpp::sha1::hash_once(a.data(), a.size()) == million_a);
+
+	char hex[SHA1_HEX_SIZE];
+	hpp::sha1("abc").finalize().print_hex(hex, true, false);
+	TEST_CHECK(std::string(hex) == "a9993e364706816aba3e25717850c26c9cd0d89d");
+	return true;
+}
+
+bool test_sha1_incremental()
+{
+	std::vector<uint8_t> bytes(1001);
+	for(size_t i = 0; i < bytes.size(); ++i)
+	{
+		bytes[i] = static_cast<uint8_t>(i * 7 + 3);
+	}
+	// from an odd address, so block loads are unaligned
+	const uint8_t* message = bytes.data() + 1;
+	const size_t size = bytes.size() - 1;
+	const auto expected = hpp::sha1::hash_once(message, size);
+
+	for(size_t chunk = 1; chunk <= 130; ++chunk)
+	{
+		hpp::sha1 hasher;
+		for(size_t offset = 0; offset < size; offset += chunk)
+		{
+			hasher.add(message + offset, (std::min)(chunk, size - offset));
+		}
+		hasher.finalize();
+		TEST_CHECK(std::equal(std::begin(hasher.state), std::end(hasher.state), expected.begin()));
+	}
+
+	hpp::sha1 bytewise;
+	for(size_t i = 0; i < size; ++i)
+	{
+		bytewise.add(message[i]);
+	}
+	bytewise.finalize();
+	TEST_CHECK(std::equal(std::begin(bytewise.state), std::end(bytewise.state), expected.begin()));
+	return true;
+}
+
+bool test_uuid_name_generator()
+{
+	hpp::uuid_name_generator generator(hpp::uuid_namespace_dns);
+
+	// RFC 9562 test vector, 886313e1-3b8a-5372-9b90-0c9aee199e5d in byte order
+	const std::array<uint8_t, 16> python_org{
+		{0x88, 0x63, 0x13, 0xe1, 0x3b, 0x8a, 0x53, 0x72, 0x9b, 0x90, 0x0c, 0x9a, 0xee, 0x19, 0x9e, 0x5d}};
+	TEST_CHECK(generator("python.org") == hpp::uuid(python_org));
+
+	// the batch hashes several names at once and must agree with one by one
+	std::vector<std::string> names;
+	for(size_t i = 0; i < 150; ++i)
+	{
+		names.push_back(std::string(i % 70, char('a' + i % 26)) + std::to_string(i));
+	}
+	const auto batch = generator.generate_batch(hpp::span<const std::string>(names));
+	TEST_CHECK(batch.size() == names.size());
+	for(size_t i = 0; i < names.size(); ++i)
+	{
+		TEST_CHECK(batch[i] == generator(names[i]));
+		TEST_CHECK(batch[i].version() == hpp::uuid_version::name_based_sha1);
+	}
+	return true;
+}
+
+bool test_uuid_parse_format()
+{
+	// wide strings and braces take the scalar parser and formatter, narrow
+	// canonical strings the SSSE3 ones when the cpu has them
+	uint32_t seed = 12345;
+	for(int i = 0; i < 256; ++i)
+	{
+		std::array<uint8_t, 16> bytes;
+		for(auto& byte : bytes)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			byte = static_cast<uint8_t>(seed >> 24);
+		}
+		// every variant, microsoft ones format with swapped fields
+		bytes[8] = static_cast<uint8_t>((bytes[8] & 0x1f) | (i & 7) << 5);
+		const hpp::uuid id(bytes);
+
+		const auto text = id.to_string();
+		const auto wide = id.to_string<wchar_t>();
+		TEST_CHECK(text.size() == 36 && wide.size() == 36);
+		TEST_CHECK(std::equal(text.begin(), text.end(), wide.begin(),
+							  [](char c, wchar_t w) { return wchar_t(c) == w; }));
+
+		const auto parsed = hpp::uuid::from_string(text);
+		const auto parsed_wide = hpp::uuid::from_string(wide);
+		const auto parsed_braced = hpp::uuid::from_string("{" + text + "}");
+		TEST_CHECK(parsed && parsed_wide && parsed_braced);
+		TEST_CHECK(*parsed == *parsed_wide && *parsed == *parsed_braced);
+		const auto parsed_upper = hpp::uuid::from_string(id.to_string_upper());
+		TEST_CHECK(parsed_upper && *parsed_upper == *parsed);
+
+		auto broken = text;
+		broken[i % 36] = broken[i % 36] == '-' ? '0' : 'g';
+		TEST_CHECK(!hpp::uuid::from_string(broken));
+		TEST_CHECK(!hpp::uuid::is_valid_uuid(broken));
+	}
+	return true;
+}
+
+bool test_uuid_fast_random_generator()
+{
+	hpp::uuid_fast_random_generator generator;
+	std::vector<hpp::uuid> ids(10000);
+	generator.fill(ids);
+	ids.push_back(generator());
+
+	std::vector<hpp::uuid> other_thread(10000);
+	std::thread([&other_thread]() { hpp::uuid_fast_random_generator().fill(other_thread); }).join();
+	ids.insert(ids.end(), other_thread.begin(), other_thread.end());
+
+	std::set<hpp::uuid> unique;
+	for(const auto& id : ids)
+	{
+		TEST_CHECK(id.version() == hpp::uuid_version::random_number_based);
+		TEST_CHECK(id.variant() == hpp::uuid_variant::rfc);
+		unique.insert(id);
+	}
+	TEST_CHECK(unique.size() == ids.size());
+
+#ifdef HPP_UUID_HAS_ATFORK
+	// the child reseeds instead of repeating the parent's next uuid
+	int fds[2];
+	TEST_CHECK(pipe(fds) == 0);
+	const auto child = fork();
+	TEST_CHECK(child >= 0);
+	if(child == 0)
+	{
+		const auto id = generator();
+		const auto written = write(fds[1], &id, sizeof(id));
+		_exit(written == sizeof(id) ? 0 : 1);
+	}
+	const auto parent_id = generator();
+	hpp::uuid child_id;
+	const auto received = read(fds[0], &child_id, sizeof(child_id));
+	int status = 0;
+	waitpid(child, &status, 0);
+	close(fds[0]);
+	close(fds[1]);
+	TEST_CHECK(received == sizeof(child_id) && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+	TEST_CHECK(child_id != parent_id);
+#endif
+	return true;
+}
+
+bool test_uuid_hash()
+{
+	// patterns that cancel in a plain xor of the halves: equal, swapped and
+	// zero halves
+	std::unordered_set<size_t> hashes;
+	const size_t count = 20000;
+	for(uint64_t i = 0; i < count; ++i)
+	{
+		std::array<uint8_t, 16> equal;
+		std::array<uint8_t, 16> zero_high{};
+		for(size_t byte = 0; byte < 8; ++byte)
+		{
+			equal[byte] = equal[byte + 8] = static_cast<uint8_t>(i >> (byte * 8));
+			zero_high[byte] = static_cast<uint8_t>((i + count) >> (byte * 8));
+		}
+		hashes.insert(hpp::uuid_hash{}(hpp::uuid(equal)));
+		hashes.insert(hpp::uuid_hash{}(hpp::uuid(zero_high)));
+	}
+	TEST_CHECK(hashes.size() == 2 * count);
+
+	// flipping any input bit flips about half of the output bits
+	hpp::uuid_fast_random_generator generator;
+	size_t flipped_bits = 0;
+	size_t flips = 0;
+	for(int sample = 0; sample < 200; ++sample)
+	{
+		const auto id = generator();
+		const auto hash = hpp::uuid_hash{}(id);
+		TEST_CHECK(std::hash<hpp::uuid>{}(id) == hash);
+		TEST_CHECK(hpp::uuid_hash{}(id.to_string()) == hash);
+		for(size_t bit = 0; bit < 128; ++bit)
+		{
+			auto bytes = id.as_array();
+			bytes[bit / 8] ^= static_cast<uint8_t>(1u << (bit % 8));
+			flipped_bits += std::bitset<64>(uint64_t(hash ^ hpp::uuid_hash{}(hpp::uuid(bytes)))).count();
+			flips++;
+		}
+	}
+	const double average = double(flipped_bits) / double(flips);
+	TEST_CHECK(average > sizeof(size_t) * 8 * 0.45 && average < sizeof(size_t) * 8 * 0.55);
+
+	// heterogeneous lookup with a string
+	std::unordered_set<hpp::uuid, hpp::uuid_hash, hpp::uuid_equal> set;
+	const auto id = generator();
+	set.insert(id);
+	TEST_CHECK(set.find(hpp::string_view(id.to_string())) != set.end());
+	return true;
+}
+
+bool test_slot_map_batch()
+{
+	using map_type = hpp::slot_map<uint64_t>;
+	using key_type = map_type::key_type;
+
+	map_type map;
+	std::vector<key_type> keys(1000);
+	map.emplace_n(keys, uint64_t(7));
+	TEST_CHECK(map.size() == 1000 && map[keys[999]] == 7);
+
+	std::vector<uint64_t> values(500);
+	for(size_t i = 0; i < values.size(); ++i)
+	{
+		values[i] = i;
+	}
+	std::vector<key_type> range_keys(values.size());
+	map.insert_range(values.begin(), values.end(), hpp::span<key_type>(range_keys));
+	TEST_CHECK(map.size() == 1500 && map[range_keys[42]] == 42);
+
+	TEST_CHECK(map.erase_many(hpp::span<const key_type>(keys)) == 1000);
+	TEST_CHECK(map.erase_many(hpp::span<const key_type>(keys)) == 0);
+	TEST_CHECK(map.size() == 500 && map.find(keys[0]) == map.end());
+	for(size_t i = 0; i < range_keys.size(); ++i)
+	{
+		TEST_CHECK(map[range_keys[i]] == i);
+	}
+	return true;
+}
+
+struct counted_copy
+{
+	static int live;
+	static int copies_left;
+
+	counted_copy()
+	{
+		++live;
+	}
+	counted_copy(const counted_copy&)
+	{
+		if(copies_left-- == 0)
+		{
+			throw std::runtime_error("copy");
+		}
+		++live;
+	}
+	~counted_copy()
+	{
+		--live;
+	}
+};
+int counted_copy::live = 0;
+int counted_copy::copies_left = 0;
+
+struct alignas(64) over_aligned
+{
+	int value{};
+};
+
+bool test_chunked_vector()
+{
+	using vector_type = hpp::chunked_vector<int, hpp::chunk_size<4>>;
+	vector_type values;
+	values.push_back(0);
+	const int* first = &values[0];
+	for(int i = 1; i < 100; ++i)
+	{
+		values.push_back(i);
+	}
+	TEST_CHECK(first == &values[0] && values.size() == 100 && values.capacity() == 100);
+	TEST_CHECK(values.back() == 99 && values.at(42) == 42);
+
+	values.erase(values.begin() + 10, values.begin() + 20);
+	TEST_CHECK(values.size() == 90 && values[10] == 20 && values.back() == 99);
+
+	vector_type copy(values);
+	TEST_CHECK(copy.size() == values.size() && std::equal(copy.begin(), copy.end(), values.begin()));
+
+	hpp::chunked_vector<over_aligned> aligned;
+	for(int i = 0; i < 10; ++i)
+	{
+		aligned.push_back(over_aligned{i});
+		TEST_CHECK(reinterpret_cast<uintptr_t>(&aligned.back()) % 64 == 0);
+	}
+
+	{
+		hpp::chunked_vector<counted_copy, hpp::chunk_size<4>> source;
+		for(int i = 0; i < 10; ++i)
+		{
+			source.emplace_back();
+		}
+		counted_copy::copies_left = 5;
+		bool thrown = false;
+		try
+		{
+			auto partial = source;
+		}
+		catch(const std::runtime_error&)
+		{
+			thrown = true;
+		}
+		TEST_CHECK(thrown && counted_copy::live == 10);
+	}
+	TEST_CHECK(counted_copy::live == 0);
+
+	hpp::slot_map<std::string, std::pair<uint32_t, uint32_t>, hpp::chunked_vector> map;
+	auto key = map.emplace("first");
+	const auto* value = &map[key];
+	for(int i = 0; i < 10000; ++i)
+	{
+		map.emplace(std::to_string(i));
+	}
+	TEST_CHECK(value == &map[key] && *value == "first" && map.size() == 10001);
+	return true;
+}
+
+bool test_packed_key_slot_map()
+{
+	static_assert(sizeof(hpp::packed_key32) == 4, "packed_key32 is 4 bytes");
+	static_assert(sizeof(hpp::packed_key64) == 8, "packed_key64 is 8 bytes");
+
+	hpp::packed_key32 key(5, 7);
+	TEST_CHECK(key.index() == 5 && key.generation() == 7);
+	TEST_CHECK(hpp::packed_key32::from_value(key.value()) == key);
+
+	hpp::slot_map<int, hpp::packed_key32> map;
+	std::vector<hpp::packed_key32> old_keys;
+	auto first = map.emplace(1);
+	old_keys.push_back(first);
+	map.erase(first);
+	// Reuse slot 0 until its 12 bit generation wraps and the slot is retired.
+	for(;;)
+	{
+		auto next = map.emplace(2);
+		if(next.index() != 0)
+		{
+			break;
+		}
+		old_keys.push_back(next);
+		map.erase(next);
+	}
+	TEST_CHECK(old_keys.size() > 1000 && old_keys.size() <= 4096);
+	for(const auto& old_key : old_keys)
+	{
+		TEST_CHECK(map.find(old_key) == map.end());
+	}
+	TEST_CHECK(map.size() == 1);
+
+	map.clear();
+	TEST_CHECK(map.emplace(3).index() == 0);
+
+	hpp::slot_map<int, hpp::packed_key64> map64;
+	auto key64 = map64.emplace(64);
+	TEST_CHECK(map64[key64] == 64 && std::hash<hpp::packed_key64>()(key64) == std::hash<uint64_t>()(key64.value()));
+	map64.erase(key64);
+	TEST_CHECK(map64.find(key64) == map64.end() && map64.emplace(65).index() == key64.index());
+	return true;
+}
+
+bool test_slot_map_find_many()
+{
+	using map_type = hpp::slot_map<uint64_t>;
+	using key_type = map_type::key_type;
+
+	map_type map;
+	std::vector<key_type> keys;
+	for(uint64_t i = 0; i < 100; ++i)
+	{
+		keys.push_back(map.emplace(i));
+	}
+	map.erase(keys[3]);
+	keys.push_back(key_type{1000, 1}); // index past the slots
+	keys.push_back(key_type{5, 0});    // wrong generation
+
+	std::vector<uint64_t*> out(keys.size());
+	map.find_many(keys, out);
+	for(size_t i = 0; i < 100; ++i)
+	{
+		TEST_CHECK(i == 3 ? out[i] == nullptr : *out[i] == i);
+	}
+	TEST_CHECK(out[100] == nullptr && out[101] == nullptr);
+
+	const map_type& const_map = map;
+	TEST_CHECK(const_map.find(keys[100]) == const_map.end() && const_map.find(keys[101]) == const_map.end());
+	std::vector<const uint64_t*> const_out(10);
+	const_map.find_many(keys, const_out);
+	TEST_CHECK(*const_out[9] == 9 && const_out[3] == nullptr);
+
+	std::vector<size_t> visited;
+	uint64_t sum = 0;
+	const_map.visit_many(keys,
+						 [&](size_t i, const uint64_t& value)
+						 {
+							 visited.push_back(i);
+							 sum += value;
+						 });
+	TEST_CHECK(visited.size() == 99 && visited[3] == 4 && sum == 99 * 100 / 2 - 3);
+	map.visit_many(keys, [](size_t, uint64_t& value) { value *= 2; });
+	TEST_CHECK(map[keys[50]] == 100);
+	return true;
+}
+
+struct throw_on_copy
+{
+	throw_on_copy() = default;
+	throw_on_copy(throw_on_copy&&) = default;
+	throw_on_copy(const throw_on_copy&)
+	{
+		throw std::runtime_error("copy");
+	}
+	throw_on_copy& operator=(throw_on_copy&&) = default;
+	throw_on_copy& operator=(const throw_on_copy&) = default;
+};
+
+
+bool test_soa_slot_map()
+{
+	hpp::soa_slot_map<int, std::string> map;
+	auto a = map.emplace(1, "one");
+	auto b = map.insert(2, "two");
+	TEST_CHECK(map.size() == 2 && map.column<0>().size() == 2);
+	TEST_CHECK(*map.find<0>(a) == 1 && map.at<1>(b) == "two");
+
+	TEST_CHECK(map.erase(a) == 1 && map.erase(a) == 0);
+	TEST_CHECK(!map.contains(a) && map.find<1>(a) == nullptr);
+	auto c = map.emplace(3, "three");
+	TEST_CHECK(c != a && !map.contains(a) && map.at<1>(c) == "three");
+	TEST_CHECK(map.key_at(map.index_of(b)) == b);
+
+	// a throwing column leaves the map as it was
+	hpp::soa_slot_map<int, throw_on_copy> throwing;
+	throwing.emplace(1, throw_on_copy{});
+	const throw_on_copy source;
+	bool thrown = false;
+	try
+	{
+		throwing.emplace(2, source);
+	}
+	catch(const std::runtime_error&)
+	{
+		thrown = true;
+	}
+	TEST_CHECK(thrown && throwing.size() == 1 && throwing.column<0>().size() == 1);
+	return true;
+}
+
+bool test_slot_map_parallel_for_each()
+{
+	using map_type = hpp::slot_map<uint64_t>;
+	using key_type = map_type::key_type;
+
+	map_type map;
+	std::vector<key_type> keys(10000);
+	map.emplace_n(keys, uint64_t(1));
+	map.erase_many(hpp::span<const key_type>(keys.data(), 100));
+
+	uint64_t round = 1;
+	for(size_t threads : {size_t(1), size_t(4)})
+	{
+		hpp::work_stealing_pool pool(threads);
+		std::atomic<uint64_t> sum{0};
+		hpp::parallel_for_each(
+			map, [&sum](uint64_t& value) { sum += value++; }, 16, pool);
+		TEST_CHECK(sum == 9900 * round++);
+
+		const map_type& const_map = map;
+		std::atomic<size_t> mismatches{0};
+		hpp::parallel_for_each_with_key(
+			const_map,
+			[&const_map, &mismatches](const key_type& key, const uint64_t& value)
+			{
+				if(&const_map[key] != &value)
+				{
+					++mismatches;
+				}
+			},
+			16, pool);
+		TEST_CHECK(mismatches == 0);
+	}
+
+	map_type empty;
+	std::atomic<size_t> calls{0};
+	hpp::parallel_for_each(empty, [&calls](uint64_t&) { ++calls; });
+	TEST_CHECK(calls == 0);
+	return true;
+}
+
+bool test_slot_map_snapshot()
+{
+	using map_type = hpp::slot_map<uint64_t>;
+	using key_type = map_type::key_type;
+
+	map_type map;
+	std::vector<key_type> keys(500);
+	map.emplace_n(keys, uint64_t(0));
+	for(size_t i = 0; i < keys.size(); ++i)
+	{
+		map[keys[i]] = i;
+	}
+	map.erase(keys[10]);
+
+	std::vector<uint8_t> snapshot(map.snapshot_size());
+	TEST_CHECK(map.save_snapshot(snapshot) == snapshot.size());
+	map_type loaded;
+	TEST_CHECK(loaded.load_snapshot(hpp::span<const uint8_t>(snapshot)));
+	TEST_CHECK(loaded.size() == map.size() && loaded[keys[499]] == 499 && loaded.find(keys[10]) == loaded.end());
+	// the free list comes along, so both maps hand out the same next key
+	TEST_CHECK(loaded.emplace(uint64_t(1)) == map.emplace(uint64_t(1)));
+
+	// truncated input leaves the map as it was
+	TEST_CHECK(!loaded.load_snapshot(hpp::span<const uint8_t>(snapshot.data(), snapshot.size() - 1)));
+	TEST_CHECK(!loaded.load_snapshot(hpp::span<const uint8_t>(snapshot.data(), 3)));
+	TEST_CHECK(loaded.size() == map.size());
+
+	std::vector<uint8_t> too_small(snapshot.size() - 1);
+	bool thrown = false;
+	try
+	{
+		map.save_snapshot(too_small);
+	}
+	catch(const std::length_error&)
+	{
+		thrown = true;
+	}
+	TEST_CHECK(thrown);
+
+	std::stringstream stream;
+	TEST_CHECK(hpp::save_snapshot(map, stream));
+	map_type streamed;
+	TEST_CHECK(hpp::load_snapshot(streamed, stream));
+	TEST_CHECK(streamed.size() == map.size() && streamed[keys[7]] == 7);
+
+	std::string cut = stream.str();
+	cut.resize(cut.size() / 2);
+	std::stringstream truncated(cut);
+	map_type untouched;
+	TEST_CHECK(!hpp::load_snapshot(untouched, truncated) && untouched.empty());
+	return true;
+}
+
+bool test_generational_arena()
+{
+	static int alive = 0;
+	struct counted
+	{
+		explicit counted(int v)
+			: value(v)
+		{
+			alive++;
+		}
+		~counted()
+		{
+			alive--;
+		}
+		int value;
+	};
+
+	{
+		hpp::generational_arena<> arena(sizeof(counted), alignof(counted), 4);
+		std::vector<hpp::generational_arena<>::key_type> keys;
+		for(int i = 0; i < 10; ++i)
+		{
+			keys.push_back(arena.create<counted>(i));
+		}
+		TEST_CHECK(alive == 10 && arena.size() == 10);
+		TEST_CHECK(arena.get_as<counted>(keys[3])->value == 3);
+
+		TEST_CHECK(arena.deallocate(keys[3]) && !arena.deallocate(keys[3]));
+		TEST_CHECK(alive == 9 && !arena.contains(keys[3]) && arena.get(keys[3]) == nullptr);
+
+		auto created = arena.create<counted>(42);
+		TEST_CHECK(arena.get_as<counted>(created)->value == 42 && arena.get(keys[3]) == nullptr);
+
+		auto raw = arena.allocate();
+		TEST_CHECK(arena.get(raw) != nullptr && arena.deallocate(raw));
+	}
+	TEST_CHECK(alive == 0);
+	return true;
+}
+
+bool test_slot_map_shrink_to_fit()
+{
+	using map_type = hpp::slot_map<uint64_t>;
+	using key_type = map_type::key_type;
+
+	map_type map;
+	std::vector<key_type> keys(1000);
+	map.emplace_n(keys, uint64_t(7));
+	std::vector<key_type> kept;
+	for(size_t i = 0; i < keys.size(); ++i)
+	{
+		if(i % 100 == 0)
+		{
+			kept.push_back(keys[i]);
+		}
+		else
+		{
+			map.erase(keys[i]);
+		}
+	}
+	auto before = map.memory_usage();
+	TEST_CHECK(before.free_slot_count == 990);
+
+	map.shrink_to_fit();
+	auto after = map.memory_usage();
+	TEST_CHECK(after.slots_bytes < before.slots_bytes && after.values_bytes < before.values_bytes);
+	TEST_CHECK(after.free_slot_count == 891 && map.capacity_slots() == 901);
+	for(const auto& key : kept)
+	{
+		TEST_CHECK(map[key] == 7);
+	}
+
+	// dropped slots come back with a generation past every stale key
+	for(int i = 0; i < 1000; ++i)
+	{
+		map.emplace(uint64_t(1));
+	}
+	for(size_t i = 0; i < keys.size(); ++i)
+	{
+		TEST_CHECK((i % 100 == 0) == (map.find(keys[i]) != map.end()));
+	}
+	return true;
+}
+
+std::vector<int> event_calls;
+void event_slot_a(int)
+{
+	event_calls.push_back(1);
+}
+void event_slot_b(int)
+{
+	event_calls.push_back(2);
+}
+
+template<typename Event>
+bool test_event_order()
+{
+	event_calls.clear();
+	Event e;
+	e.connect(-1, &event_slot_b);
+	e.connect(5, &event_slot_a);
+	e.connect([](int) { event_calls.push_back(3); });
+	e.emit(0);
+	TEST_CHECK((event_calls == std::vector<int>{1, 3, 2}));
+
+	// equal when the same functions are connected with the same priorities
+	Event same;
+	same.connect(5, &event_slot_a);
+	same.connect(-1, &event_slot_b);
+	Event other = same;
+	TEST_CHECK(same == other && !(same != other) && !(e == same));
+	other.disconnect(&event_slot_b);
+	TEST_CHECK(same != other);
+	TEST_CHECK(Event() == Event());
+
+	// a slot whose sentinel expired no longer counts as connected
+	Event guarded;
+	auto owner = std::make_shared<int>(1);
+	guarded.connect(hpp::sentinel(owner), &event_slot_a);
+	TEST_CHECK(!guarded.empty());
+	owner.reset();
+	TEST_CHECK(guarded.empty() && guarded == Event());
+
+	// disconnected while emitting, skipped by the same emit
+	event_calls.clear();
+	Event d;
+	typename Event::slot_key second{};
+	d.connect(1, [&](int) { d.disconnect(second); });
+	second = d.connect(&event_slot_b);
+	d.emit(0);
+	TEST_CHECK(event_calls.empty() && d.empty() == false);
+	return true;
+}
+
+bool test_event_slot_storage()
+{
+	return test_event_order<hpp::event<void(int)>>() && test_event_order<hpp::contiguous_event<void(int)>>();
+}
+
+template<typename Event>
+bool test_event_storage()
+{
+	Event a;
+	Event b;
+	int calls_a = 0;
+	int calls_b = 0;
+	{
+		auto connection = a.make_connection(a.connect([&calls_a](int) { calls_a++; }));
+		TEST_CHECK(connection.connected());
+		a.emit(1);
+	}
+	a.emit(1);
+	TEST_CHECK(calls_a == 1 && a.empty());
+
+	// a copy gets its own slots, a connection to the old ones can not
+	// disconnect them
+	auto connection = a.make_connection(a.connect([&calls_a](int) { calls_a++; }));
+	b.connect([&calls_b](int) { calls_b++; });
+	a = b;
+	connection.disconnect();
+	a.emit(1);
+	b.emit(1);
+	TEST_CHECK(calls_a == 1 && calls_b == 2);
+
+	// connected while emitting, called from the next emit on
+	Event c;
+	int calls_c = 0;
+	c.connect([&](int) {
+		if(calls_c++ == 0)
+		{
+			c.connect(-1, [&calls_c](int) { calls_c += 10; });
+		}
+	});
+	c.emit(1);
+	c.emit(1);
+	TEST_CHECK(calls_c == 12 || calls_c == 22);
+
+	auto key = c.connect(5, [](int) {});
+	c.disconnect(key);
+	c.disconnect(key);
+	c.emit(1);
+
+	// a throwing slot does not leave the event emitting
+	Event t;
+	t.connect([&t](int) {
+		t.disconnect_current();
+		throw std::runtime_error("slot");
+	});
+	bool thrown = false;
+	try
+	{
+		t.emit(1);
+	}
+	catch(const std::runtime_error&)
+	{
+		thrown = true;
+	}
+	TEST_CHECK(thrown && t.empty());
+	auto after = t.connect([](int) {});
+	t.disconnect(after);
+	TEST_CHECK(t.empty());
+	return true;
+}
+
+bool test_event_connection()
+{
+	if(!test_event_storage<hpp::event<void(int)>>() || !test_event_storage<hpp::contiguous_event<void(int)>>())
+	{
+		return false;
+	}
+
+	// the removed slot is erased once the throwing emit unwinds
+	hpp::event<void(int)> e;
+	e.connect([&e](int) {
+		e.disconnect_current();
+		throw std::runtime_error("slot");
+	});
+	try
+	{
+		e.emit(1);
+	}
+	catch(const std::runtime_error&)
+	{
+	}
+	TEST_CHECK(e.get_slots().empty());
+	return true;
+}
+
+bool test_concurrent_event()
+{
+	hpp::concurrent_event<void(int)> e;
+	std::vector<int> calls;
+	e.connect(-1, [&calls](int v) { calls.push_back(v * 10); });
+	auto key = e.connect(5, [&calls](int v) { calls.push_back(v); });
+	e.emit(1);
+	TEST_CHECK((calls == std::vector<int>{1, 10}) && e.size() == 2);
+	e.disconnect(key);
+	e.disconnect(key);
+	TEST_CHECK(e.size() == 1);
+
+	// connected while emitting, called from the next emit on
+	int late_calls = 0;
+	hpp::concurrent_event<void(int)> c;
+	c.connect([&](int) {
+		c.connect([&late_calls](int) { late_calls++; });
+		c.disconnect_current();
+	});
+	c.emit(0);
+	TEST_CHECK(late_calls == 0 && c.size() == 1);
+	c.emit(0);
+	TEST_CHECK(late_calls == 1);
+
+	// both events number their slots from the same start, so the first
+	// slot of a and of b share a key value
+	hpp::concurrent_event<void(int)> a;
+	hpp::concurrent_event<void(int)> b;
+	int a_calls = 0;
+	int b_calls = 0;
+	b.connect([&](int) {
+		b_calls++;
+		a.disconnect_current();
+	});
+	a.connect([&](int) {
+		a_calls++;
+		b.emit(0);
+	});
+	a.connect([&](int) { a_calls++; });
+	TEST_CHECK(b.size() == 1);
+	b.emit(0);
+	a.emit(0);
+	TEST_CHECK(b.size() == 1 && a.size() == 1 && a_calls == 2 && b_calls == 2);
+
+	// emits on other threads while slots come and go
+	hpp::concurrent_event<void(int)> shared;
+	std::atomic<int> sum{0};
+	shared.connect([&sum](int v) { sum += v; });
+	std::atomic<bool> done{false};
+	std::vector<std::thread> emitters;
+	for(int i = 0; i < 2; ++i)
+	{
+		emitters.emplace_back([&]() {
+			while(!done)
+			{
+				shared.emit(1);
+			}
+		});
+	}
+	for(int i = 0; i < 1000; ++i)
+	{
+		shared.disconnect(shared.connect([](int) {}));
+	}
+	done = true;
+	for(auto& emitter : emitters)
+	{
+		emitter.join();
+	}
+	TEST_CHECK(shared.size() == 1);
+	return true;
+}
+
+bool test_queued_event()
+{
+	hpp::queued_event<void(int)> queued(4);
+	std::vector<int> got;
+	queued.connect([&got](int value) { got.push_back(value); });
+	for(int i = 0; i < 6; ++i)
+	{
+		queued.emit(i);
+	}
+	TEST_CHECK(got.empty() && queued.queued() == 4 && queued.dropped() == 2);
+	queued.flush();
+	TEST_CHECK((got == std::vector<int>{2, 3, 4, 5}) && queued.queued() == 0);
+
+	size_t batched = 0;
+	queued.connect_batch([&batched](hpp::span<const std::tuple<int>> batch) { batched += batch.size(); });
+	queued.emit(6);
+	queued.emit(7);
+	queued.flush();
+	TEST_CHECK(batched == 2 && got.size() == 6);
+
+	hpp::queued_event<void(int), hpp::queue_coalesce> coalesced;
+	hpp::queued_event<void(int), hpp::queue_latest> latest;
+	int coalesced_calls = 0;
+	int last = 0;
+	coalesced.connect([&coalesced_calls](int) { coalesced_calls++; });
+	latest.connect([&last](int value) { last = value; });
+	for(int value : {1, 1, 2, 2, 1})
+	{
+		coalesced.emit(value);
+		latest.emit(value);
+	}
+	TEST_CHECK(coalesced.queued() == 3 && latest.queued() == 1);
+	coalesced.flush();
+	latest.flush();
+	TEST_CHECK(coalesced_calls == 3 && last == 1);
+
+	// a throwing slot keeps the tuples it did not get to
+	hpp::queued_event<void(int)> throwing;
+	std::vector<int> delivered;
+	throwing.connect([&delivered](int value) {
+		delivered.push_back(value);
+		if(value == 1 && delivered.size() == 2)
+		{
+			throw std::runtime_error("slot");
+		}
+	});
+	for(int i = 0; i < 4; ++i)
+	{
+		throwing.emit(i);
+	}
+	bool thrown = false;
+	try
+	{
+		throwing.flush();
+	}
+	catch(const std::runtime_error&)
+	{
+		thrown = true;
+	}
+	TEST_CHECK(thrown && throwing.queued() == 2);
+	throwing.flush();
+	TEST_CHECK((delivered == std::vector<int>{0, 1, 2, 3}));
+	return true;
+}
+
+bool test_event_bus()
+{
+	hpp::event_bus<void(int, int)> bus(64);
+	std::vector<int> next(4);
+	bool ordered = true;
+	int received = 0;
+	bus.connect(std::this_thread::get_id(), [&](int producer, int sequence) {
+		ordered = ordered && sequence >= next[producer];
+		next[producer] = sequence + 1;
+		received++;
+	});
+
+	std::vector<std::thread> producers;
+	for(int p = 0; p < 4; ++p)
+	{
+		producers.emplace_back([&bus, p]() {
+			for(int i = 0; i < 1000; ++i)
+			{
+				bus.emit(p, i);
+			}
+		});
+	}
+	// a full mailbox drops the new tuple, the queued ones stay in order
+	while(received + int(bus.dropped()) < 4000)
+	{
+		if(bus.dispatch() == 0)
+		{
+			std::this_thread::yield();
+		}
+	}
+	for(auto& producer : producers)
+	{
+		producer.join();
+	}
+	TEST_CHECK(ordered && received + int(bus.dropped()) == 4000 && bus.dispatch() == 0);
+
+	// a consumer thread with its own mailbox, closed before it exits
+	int consumer_calls = 0;
+	bool consumer_closed = false;
+	std::thread::id consumer_id;
+	std::thread consumer([&]() {
+		consumer_id = std::this_thread::get_id();
+		bus.connect(consumer_id, [&consumer_calls](int, int) { consumer_calls++; });
+		bus.emit(0, 0);
+		bus.dispatch();
+		consumer_closed = bus.close();
+	});
+	consumer.join();
+	TEST_CHECK(consumer_closed && consumer_calls == 1 && bus.dispatch() == 1);
+
+	// only this thread's mailbox overflows, the closed one takes nothing
+	const auto dropped = bus.dropped();
+	for(int i = 0; i < 200; ++i)
+	{
+		bus.emit(0, i);
+	}
+	TEST_CHECK(bus.dropped() == dropped + 200 - bus.mailbox_capacity());
+	TEST_CHECK(bus.queued(consumer_id) == 0 && !bus.close(consumer_id));
+	TEST_CHECK(bus.dispatch() == bus.mailbox_capacity() && consumer_calls == 1);
+
+	// a one cell ring can not tell a full cell from a free one, so the
+	// capacity is at least two
+	hpp::event_bus<void(int)> small(1);
+	std::vector<int> got;
+	small.connect(std::this_thread::get_id(), [&got](int value) { got.push_back(value); });
+	TEST_CHECK(small.mailbox_capacity() == 2);
+	for(int i = 0; i < 3; ++i)
+	{
+		small.emit(i);
+	}
+	TEST_CHECK(small.dropped() == 1 && small.dispatch() == 2 && (got == std::vector<int>{0, 1}));
+
+	// closed mailboxes are freed with their slots, not kept until the bus goes
+	auto token = std::make_shared<int>(0);
+	for(int i = 0; i < 100; ++i)
+	{
+		std::thread closer([&small, token]() {
+			small.connect(std::this_thread::get_id(), [token](int) {});
+			small.emit(0);
+			small.close();
+		});
+		closer.join();
+		small.dispatch();
+	}
+	TEST_CHECK(token.use_count() <= 3);
+	small.dispatch();
+	TEST_CHECK(token.use_count() == 1);
+	return true;
+}
+
 int main()
 {
     static_assert(hpp::type_name<int>() == "int", "not working");
@@ -60,5 +1416,132 @@ int main()
 	auto res1 = hpp::apply(invokeable, tup);
 	std::cout << "apply returned " << res1 << std::endl;
 
+	static_assert(hpp::crc64("123456789", 9) == hpp::hash_impl("6789", 4, hpp::crc64("12345", 5)), "not working");
+
+	if(!test_concurrent_slot_map())
+	{
+		return 1;
+	}
+
+	if(!test_crc64_fast())
+	{
+		return 1;
+	}
+
+	if(!test_crc64_hasher())
+	{
+		return 1;
+	}
+
+	if(!test_crc64_parallel())
+	{
+		return 1;
+	}
+
+	if(!test_sha1_batch())
+	{
+		return 1;
+	}
+
+	if(!test_sha1_known_vectors())
+	{
+		return 1;
+	}
+
+	if(!test_sha1_incremental())
+	{
+		return 1;
+	}
+
+	if(!test_uuid_name_generator())
+	{
+		return 1;
+	}
+
+	if(!test_uuid_parse_format())
+	{
+		return 1;
+	}
+
+	if(!test_uuid_fast_random_generator())
+	{
+		return 1;
+	}
+
+	if(!test_uuid_hash())
+	{
+		return 1;
+	}
+
+	if(!test_slot_map_batch())
+	{
+		return 1;
+	}
+
+	if(!test_chunked_vector())
+	{
+		return 1;
+	}
+
+	if(!test_packed_key_slot_map())
+	{
+		return 1;
+	}
+
+	if(!test_slot_map_find_many())
+	{
+		return 1;
+	}
+
+	if(!test_soa_slot_map())
+	{
+		return 1;
+	}
+
+	if(!test_slot_map_parallel_for_each())
+	{
+		return 1;
+	}
+
+	if(!test_slot_map_snapshot())
+	{
+		return 1;
+	}
+
+	if(!test_generational_arena())
+	{
+		return 1;
+	}
+
+	if(!test_slot_map_shrink_to_fit())
+	{
+		return 1;
+	}
+
+	if(!test_event_slot_storage())
+	{
+		return 1;
+	}
+
+	if(!test_event_connection())
+	{
+		return 1;
+	}
+
+	if(!test_concurrent_event())
+	{
+		return 1;
+	}
+
+	if(!test_queued_event())
+	{
+		return 1;
+	}
+
+	if(!test_event_bus())
+	{
+		return 1;
+	}
+
 	return 0;
 }